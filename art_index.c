@@ -0,0 +1,897 @@
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "art_index.h"
+
+#define ART_NODE4 1
+#define ART_NODE16 2
+#define ART_NODE48 3
+#define ART_NODE256 4
+#define ART_LEAF 5
+
+// prefix bytes kept inside a node, longer prefixes are read from a leaf
+#define ART_MAX_PREFIX 10
+
+#define ART_MIN(a, b) ((a) < (b) ? (a) : (b))
+
+struct ArtNode {
+	unsigned char type;
+	int numOfChildren;
+	int prefixLength;
+	unsigned char prefix[ART_MAX_PREFIX];
+};
+
+typedef struct ArtNode4 {
+	ArtNode n;
+	unsigned char keys[4];
+	ArtNode *children[4];
+} ArtNode4;
+
+typedef struct ArtNode16 {
+	ArtNode n;
+	unsigned char keys[16];
+	ArtNode *children[16];
+} ArtNode16;
+
+typedef struct ArtNode48 {
+	ArtNode n;
+	unsigned char childIndex[256];	// position in children plus one, 0 when empty
+	ArtNode *children[48];
+} ArtNode48;
+
+typedef struct ArtNode256 {
+	ArtNode n;
+	ArtNode *children[256];
+} ArtNode256;
+
+typedef struct ArtLeaf {
+	unsigned char type;
+	void *value;
+	int keyLength;
+	unsigned char key[1];
+} ArtLeaf;
+
+/*
+ * allocate an empty inner node of the given type
+ */
+static ArtNode *createNode (ArtTree *tree, unsigned char type)
+{
+	ArtNode *n;
+
+	switch(type)
+	{
+	case ART_NODE4:
+		n = (ArtNode*)calloc(1, sizeof(ArtNode4));
+		break;
+	case ART_NODE16:
+		n = (ArtNode*)calloc(1, sizeof(ArtNode16));
+		break;
+	case ART_NODE48:
+		n = (ArtNode*)calloc(1, sizeof(ArtNode48));
+		break;
+	default:
+		n = (ArtNode*)calloc(1, sizeof(ArtNode256));
+		break;
+	}
+	n->type = type;
+	tree->numOfNodes++;
+	return n;
+}
+
+/*
+ * release an inner node that has been replaced by a grown or shrunk copy
+ */
+static void releaseNode (ArtTree *tree, ArtNode *n)
+{
+	free(n);
+	tree->numOfNodes--;
+}
+
+static ArtLeaf *createLeaf (unsigned char *key, int keyLength, void *value)
+{
+	ArtLeaf *l = (ArtLeaf*)malloc(sizeof(ArtLeaf) + keyLength);
+
+	l->type = ART_LEAF;
+	l->value = value;
+	l->keyLength = keyLength;
+	memcpy(l->key, key, keyLength);
+	return l;
+}
+
+static int leafMatches (ArtLeaf *l, unsigned char *key, int keyLength)
+{
+	return l->keyLength == keyLength && memcmp(l->key, key, keyLength) == 0;
+}
+
+/*
+ * order the key of a leaf against a search key
+ */
+static int compareLeaf (ArtLeaf *l, unsigned char *key, int keyLength)
+{
+	int cmp = memcmp(l->key, key, ART_MIN(l->keyLength, keyLength));
+
+	if(cmp != 0)
+		return cmp;
+	return l->keyLength - keyLength;
+}
+
+/*
+ * copy the child count and the compressed path into a grown or shrunk node
+ */
+static void copyHeader (ArtNode *dest, ArtNode *src)
+{
+	dest->numOfChildren = src->numOfChildren;
+	dest->prefixLength = src->prefixLength;
+	memcpy(dest->prefix, src->prefix, ART_MIN(ART_MAX_PREFIX, src->prefixLength));
+}
+
+static ArtNode **findChild (ArtNode *n, unsigned char c)
+{
+	int i;
+
+	switch(n->type)
+	{
+	case ART_NODE4:
+	{
+		ArtNode4 *p = (ArtNode4*)n;
+		for(i = 0; i < n->numOfChildren; i++)
+			if(p->keys[i] == c)
+				return &p->children[i];
+		return NULL;
+	}
+	case ART_NODE16:
+	{
+		ArtNode16 *p = (ArtNode16*)n;
+		for(i = 0; i < n->numOfChildren; i++)
+			if(p->keys[i] == c)
+				return &p->children[i];
+		return NULL;
+	}
+	case ART_NODE48:
+	{
+		ArtNode48 *p = (ArtNode48*)n;
+		if(p->childIndex[c])
+			return &p->children[p->childIndex[c] - 1];
+		return NULL;
+	}
+	default:
+	{
+		ArtNode256 *p = (ArtNode256*)n;
+		if(p->children[c])
+			return &p->children[c];
+		return NULL;
+	}
+	}
+}
+
+/*
+ * first child whose byte is greater than c
+ */
+static ArtNode *nextChild (ArtNode *n, unsigned char c)
+{
+	int i;
+
+	switch(n->type)
+	{
+	case ART_NODE4:
+	{
+		ArtNode4 *p = (ArtNode4*)n;
+		for(i = 0; i < n->numOfChildren; i++)
+			if(p->keys[i] > c)
+				return p->children[i];
+		return NULL;
+	}
+	case ART_NODE16:
+	{
+		ArtNode16 *p = (ArtNode16*)n;
+		for(i = 0; i < n->numOfChildren; i++)
+			if(p->keys[i] > c)
+				return p->children[i];
+		return NULL;
+	}
+	case ART_NODE48:
+	{
+		ArtNode48 *p = (ArtNode48*)n;
+		for(i = c + 1; i < 256; i++)
+			if(p->childIndex[i])
+				return p->children[p->childIndex[i] - 1];
+		return NULL;
+	}
+	default:
+	{
+		ArtNode256 *p = (ArtNode256*)n;
+		for(i = c + 1; i < 256; i++)
+			if(p->children[i])
+				return p->children[i];
+		return NULL;
+	}
+	}
+}
+
+/*
+ * last child whose byte is smaller than c
+ */
+static ArtNode *prevChild (ArtNode *n, unsigned char c)
+{
+	int i;
+
+	switch(n->type)
+	{
+	case ART_NODE4:
+	{
+		ArtNode4 *p = (ArtNode4*)n;
+		for(i = n->numOfChildren - 1; i >= 0; i--)
+			if(p->keys[i] < c)
+				return p->children[i];
+		return NULL;
+	}
+	case ART_NODE16:
+	{
+		ArtNode16 *p = (ArtNode16*)n;
+		for(i = n->numOfChildren - 1; i >= 0; i--)
+			if(p->keys[i] < c)
+				return p->children[i];
+		return NULL;
+	}
+	case ART_NODE48:
+	{
+		ArtNode48 *p = (ArtNode48*)n;
+		for(i = c - 1; i >= 0; i--)
+			if(p->childIndex[i])
+				return p->children[p->childIndex[i] - 1];
+		return NULL;
+	}
+	default:
+	{
+		ArtNode256 *p = (ArtNode256*)n;
+		for(i = c - 1; i >= 0; i--)
+			if(p->children[i])
+				return p->children[i];
+		return NULL;
+	}
+	}
+}
+
+static ArtLeaf *minimumLeaf (ArtNode *n)
+{
+	while(n != NULL && n->type != ART_LEAF)
+	{
+		if(n->type == ART_NODE4)
+			n = ((ArtNode4*)n)->children[0];
+		else if(n->type == ART_NODE16)
+			n = ((ArtNode16*)n)->children[0];
+		else if(findChild(n, 0) != NULL)
+			n = *findChild(n, 0);
+		else
+			n = nextChild(n, 0);
+	}
+	return (ArtLeaf*)n;
+}
+
+static ArtLeaf *maximumLeaf (ArtNode *n)
+{
+	while(n != NULL && n->type != ART_LEAF)
+	{
+		if(n->type == ART_NODE4)
+			n = ((ArtNode4*)n)->children[n->numOfChildren - 1];
+		else if(n->type == ART_NODE16)
+			n = ((ArtNode16*)n)->children[n->numOfChildren - 1];
+		else if(findChild(n, 255) != NULL)
+			n = *findChild(n, 255);
+		else
+			n = prevChild(n, 255);
+	}
+	return (ArtLeaf*)n;
+}
+
+/*
+ * number of prefix bytes stored in the node that match the key
+ */
+static int checkPrefix (ArtNode *n, unsigned char *key, int keyLength, int depth)
+{
+	int maxCmp = ART_MIN(ART_MIN(n->prefixLength, ART_MAX_PREFIX), keyLength - depth);
+	int idx;
+
+	for(idx = 0; idx < maxCmp; idx++)
+		if(n->prefix[idx] != key[depth + idx])
+			return idx;
+	return idx;
+}
+
+/*
+ * position of the first byte where the full prefix of the node and the key differ
+ */
+static int prefixMismatch (ArtNode *n, unsigned char *key, int keyLength, int depth)
+{
+	int maxCmp = ART_MIN(ART_MIN(n->prefixLength, ART_MAX_PREFIX), keyLength - depth);
+	int idx;
+	ArtLeaf *l;
+
+	for(idx = 0; idx < maxCmp; idx++)
+		if(n->prefix[idx] != key[depth + idx])
+			return idx;
+
+	//the rest of a long prefix is only stored in the leaves
+	if(n->prefixLength > ART_MAX_PREFIX)
+	{
+		l = minimumLeaf(n);
+		maxCmp = ART_MIN(l->keyLength, keyLength) - depth;
+		for(; idx < maxCmp; idx++)
+			if(l->key[depth + idx] != key[depth + idx])
+				return idx;
+	}
+	return idx;
+}
+
+static void addChild256 (ArtNode256 *n, unsigned char c, void *child)
+{
+	n->children[c] = (ArtNode*)child;
+	n->n.numOfChildren++;
+}
+
+static void addChild48 (ArtTree *tree, ArtNode48 *n, ArtNode **ref, unsigned char c, void *child)
+{
+	ArtNode256 *newNode;
+	int pos, i;
+
+	if(n->n.numOfChildren < 48)
+	{
+		pos = 0;
+		while(n->children[pos] != NULL)
+			pos++;
+		n->children[pos] = (ArtNode*)child;
+		n->childIndex[c] = pos + 1;
+		n->n.numOfChildren++;
+		return;
+	}
+
+	//full, grow into a Node256
+	newNode = (ArtNode256*)createNode(tree, ART_NODE256);
+	for(i = 0; i < 256; i++)
+		if(n->childIndex[i])
+			newNode->children[i] = n->children[n->childIndex[i] - 1];
+	copyHeader((ArtNode*)newNode, (ArtNode*)n);
+	*ref = (ArtNode*)newNode;
+	releaseNode(tree, (ArtNode*)n);
+	addChild256(newNode, c, child);
+}
+
+static void addChild16 (ArtTree *tree, ArtNode16 *n, ArtNode **ref, unsigned char c, void *child)
+{
+	ArtNode48 *newNode;
+	int idx, i;
+
+	if(n->n.numOfChildren < 16)
+	{
+		//keep the keys sorted
+		for(idx = 0; idx < n->n.numOfChildren && n->keys[idx] < c; idx++);
+		memmove(n->keys + idx + 1, n->keys + idx, n->n.numOfChildren - idx);
+		memmove(n->children + idx + 1, n->children + idx, (n->n.numOfChildren - idx) * sizeof(ArtNode*));
+		n->keys[idx] = c;
+		n->children[idx] = (ArtNode*)child;
+		n->n.numOfChildren++;
+		return;
+	}
+
+	//full, grow into a Node48
+	newNode = (ArtNode48*)createNode(tree, ART_NODE48);
+	memcpy(newNode->children, n->children, 16 * sizeof(ArtNode*));
+	for(i = 0; i < 16; i++)
+		newNode->childIndex[n->keys[i]] = i + 1;
+	copyHeader((ArtNode*)newNode, (ArtNode*)n);
+	*ref = (ArtNode*)newNode;
+	releaseNode(tree, (ArtNode*)n);
+	addChild48(tree, newNode, ref, c, child);
+}
+
+static void addChild4 (ArtTree *tree, ArtNode4 *n, ArtNode **ref, unsigned char c, void *child)
+{
+	ArtNode16 *newNode;
+	int idx;
+
+	if(n->n.numOfChildren < 4)
+	{
+		for(idx = 0; idx < n->n.numOfChildren && n->keys[idx] < c; idx++);
+		memmove(n->keys + idx + 1, n->keys + idx, n->n.numOfChildren - idx);
+		memmove(n->children + idx + 1, n->children + idx, (n->n.numOfChildren - idx) * sizeof(ArtNode*));
+		n->keys[idx] = c;
+		n->children[idx] = (ArtNode*)child;
+		n->n.numOfChildren++;
+		return;
+	}
+
+	//full, grow into a Node16
+	newNode = (ArtNode16*)createNode(tree, ART_NODE16);
+	memcpy(newNode->keys, n->keys, 4);
+	memcpy(newNode->children, n->children, 4 * sizeof(ArtNode*));
+	copyHeader((ArtNode*)newNode, (ArtNode*)n);
+	*ref = (ArtNode*)newNode;
+	releaseNode(tree, (ArtNode*)n);
+	addChild16(tree, newNode, ref, c, child);
+}
+
+static void addChild (ArtTree *tree, ArtNode *n, ArtNode **ref, unsigned char c, void *child)
+{
+	switch(n->type)
+	{
+	case ART_NODE4:
+		addChild4(tree, (ArtNode4*)n, ref, c, child);
+		break;
+	case ART_NODE16:
+		addChild16(tree, (ArtNode16*)n, ref, c, child);
+		break;
+	case ART_NODE48:
+		addChild48(tree, (ArtNode48*)n, ref, c, child);
+		break;
+	default:
+		addChild256((ArtNode256*)n, c, child);
+		break;
+	}
+}
+
+static void removeChild256 (ArtTree *tree, ArtNode256 *n, ArtNode **ref, unsigned char c)
+{
+	ArtNode48 *newNode;
+	int i, pos = 0;
+
+	n->children[c] = NULL;
+	n->n.numOfChildren--;
+
+	//shrink into a Node48 a bit below its capacity so that a node does not flip back and forth
+	if(n->n.numOfChildren == 37)
+	{
+		newNode = (ArtNode48*)createNode(tree, ART_NODE48);
+		copyHeader((ArtNode*)newNode, (ArtNode*)n);
+		for(i = 0; i < 256; i++)
+		{
+			if(n->children[i] != NULL)
+			{
+				newNode->children[pos] = n->children[i];
+				newNode->childIndex[i] = pos + 1;
+				pos++;
+			}
+		}
+		*ref = (ArtNode*)newNode;
+		releaseNode(tree, (ArtNode*)n);
+	}
+}
+
+static void removeChild48 (ArtTree *tree, ArtNode48 *n, ArtNode **ref, unsigned char c)
+{
+	ArtNode16 *newNode;
+	int i, pos = n->childIndex[c] - 1, child = 0;
+
+	n->childIndex[c] = 0;
+	n->children[pos] = NULL;
+	n->n.numOfChildren--;
+
+	if(n->n.numOfChildren == 12)
+	{
+		newNode = (ArtNode16*)createNode(tree, ART_NODE16);
+		copyHeader((ArtNode*)newNode, (ArtNode*)n);
+		for(i = 0; i < 256; i++)
+		{
+			if(n->childIndex[i])
+			{
+				newNode->keys[child] = i;
+				newNode->children[child] = n->children[n->childIndex[i] - 1];
+				child++;
+			}
+		}
+		*ref = (ArtNode*)newNode;
+		releaseNode(tree, (ArtNode*)n);
+	}
+}
+
+static void removeChild16 (ArtTree *tree, ArtNode16 *n, ArtNode **ref, ArtNode **slot)
+{
+	ArtNode4 *newNode;
+	int pos = slot - n->children;
+
+	memmove(n->keys + pos, n->keys + pos + 1, n->n.numOfChildren - 1 - pos);
+	memmove(n->children + pos, n->children + pos + 1, (n->n.numOfChildren - 1 - pos) * sizeof(ArtNode*));
+	n->n.numOfChildren--;
+
+	if(n->n.numOfChildren == 3)
+	{
+		newNode = (ArtNode4*)createNode(tree, ART_NODE4);
+		copyHeader((ArtNode*)newNode, (ArtNode*)n);
+		memcpy(newNode->keys, n->keys, 4);
+		memcpy(newNode->children, n->children, 4 * sizeof(ArtNode*));
+		*ref = (ArtNode*)newNode;
+		releaseNode(tree, (ArtNode*)n);
+	}
+}
+
+static void removeChild4 (ArtTree *tree, ArtNode4 *n, ArtNode **ref, ArtNode **slot)
+{
+	ArtNode *child;
+	int pos = slot - n->children, prefix, sub;
+
+	memmove(n->keys + pos, n->keys + pos + 1, n->n.numOfChildren - 1 - pos);
+	memmove(n->children + pos, n->children + pos + 1, (n->n.numOfChildren - 1 - pos) * sizeof(ArtNode*));
+	n->n.numOfChildren--;
+
+	//a single child takes the place of the node, merging the paths
+	if(n->n.numOfChildren == 1)
+	{
+		child = n->children[0];
+		if(child->type != ART_LEAF)
+		{
+			prefix = n->n.prefixLength;
+			if(prefix < ART_MAX_PREFIX)
+			{
+				n->n.prefix[prefix] = n->keys[0];
+				prefix++;
+			}
+			if(prefix < ART_MAX_PREFIX)
+			{
+				sub = ART_MIN(child->prefixLength, ART_MAX_PREFIX - prefix);
+				memcpy(n->n.prefix + prefix, child->prefix, sub);
+				prefix += sub;
+			}
+			memcpy(child->prefix, n->n.prefix, ART_MIN(prefix, ART_MAX_PREFIX));
+			child->prefixLength += n->n.prefixLength + 1;
+		}
+		*ref = child;
+		releaseNode(tree, (ArtNode*)n);
+	}
+}
+
+static void removeChild (ArtTree *tree, ArtNode *n, ArtNode **ref, unsigned char c, ArtNode **slot)
+{
+	switch(n->type)
+	{
+	case ART_NODE4:
+		removeChild4(tree, (ArtNode4*)n, ref, slot);
+		break;
+	case ART_NODE16:
+		removeChild16(tree, (ArtNode16*)n, ref, slot);
+		break;
+	case ART_NODE48:
+		removeChild48(tree, (ArtNode48*)n, ref, c);
+		break;
+	default:
+		removeChild256(tree, (ArtNode256*)n, ref, c);
+		break;
+	}
+}
+
+static int insertRecursive (ArtTree *tree, ArtNode *n, ArtNode **ref, unsigned char *key, int keyLength, void *value, int depth)
+{
+	ArtNode4 *newNode;
+	ArtLeaf *l, *newLeaf;
+	ArtNode **child;
+	int lcp, maxCmp, diff;
+
+	if(n == NULL)
+	{
+		*ref = (ArtNode*)createLeaf(key, keyLength, value);
+		return 1;
+	}
+
+	//split a leaf into a Node4 holding both keys below their common prefix
+	if(n->type == ART_LEAF)
+	{
+		l = (ArtLeaf*)n;
+		if(leafMatches(l, key, keyLength))
+			return 0;
+
+		maxCmp = ART_MIN(l->keyLength, keyLength) - depth;
+		for(lcp = 0; lcp < maxCmp && l->key[depth + lcp] == key[depth + lcp]; lcp++);
+
+		newNode = (ArtNode4*)createNode(tree, ART_NODE4);
+		newNode->n.prefixLength = lcp;
+		memcpy(newNode->n.prefix, key + depth, ART_MIN(ART_MAX_PREFIX, lcp));
+		*ref = (ArtNode*)newNode;
+		addChild4(tree, newNode, ref, l->key[depth + lcp], l);
+		addChild4(tree, newNode, ref, key[depth + lcp], createLeaf(key, keyLength, value));
+		return 1;
+	}
+
+	//split the compressed path where the key leaves it
+	if(n->prefixLength)
+	{
+		diff = prefixMismatch(n, key, keyLength, depth);
+		if(diff < n->prefixLength)
+		{
+			newNode = (ArtNode4*)createNode(tree, ART_NODE4);
+			*ref = (ArtNode*)newNode;
+			newNode->n.prefixLength = diff;
+			memcpy(newNode->n.prefix, n->prefix, ART_MIN(ART_MAX_PREFIX, diff));
+
+			if(n->prefixLength <= ART_MAX_PREFIX)
+			{
+				addChild4(tree, newNode, ref, n->prefix[diff], n);
+				n->prefixLength -= diff + 1;
+				memmove(n->prefix, n->prefix + diff + 1, ART_MIN(ART_MAX_PREFIX, n->prefixLength));
+			}
+			else
+			{
+				n->prefixLength -= diff + 1;
+				l = minimumLeaf(n);
+				addChild4(tree, newNode, ref, l->key[depth + diff], n);
+				memcpy(n->prefix, l->key + depth + diff + 1, ART_MIN(ART_MAX_PREFIX, n->prefixLength));
+			}
+
+			newLeaf = createLeaf(key, keyLength, value);
+			addChild4(tree, newNode, ref, key[depth + diff], newLeaf);
+			return 1;
+		}
+		depth += n->prefixLength;
+	}
+
+	child = findChild(n, key[depth]);
+	if(child != NULL)
+		return insertRecursive(tree, *child, child, key, keyLength, value, depth + 1);
+
+	addChild(tree, n, ref, key[depth], createLeaf(key, keyLength, value));
+	return 1;
+}
+
+static ArtLeaf *deleteRecursive (ArtTree *tree, ArtNode *n, ArtNode **ref, unsigned char *key, int keyLength, int depth)
+{
+	ArtNode **child;
+	ArtLeaf *l;
+
+	if(n == NULL)
+		return NULL;
+
+	if(n->type == ART_LEAF)
+	{
+		l = (ArtLeaf*)n;
+		if(!leafMatches(l, key, keyLength))
+			return NULL;
+		*ref = NULL;
+		return l;
+	}
+
+	if(n->prefixLength)
+	{
+		if(checkPrefix(n, key, keyLength, depth) != ART_MIN(ART_MAX_PREFIX, n->prefixLength))
+			return NULL;
+		depth += n->prefixLength;
+	}
+	if(depth >= keyLength)
+		return NULL;
+
+	child = findChild(n, key[depth]);
+	if(child == NULL)
+		return NULL;
+
+	if((*child)->type == ART_LEAF)
+	{
+		l = (ArtLeaf*)*child;
+		if(!leafMatches(l, key, keyLength))
+			return NULL;
+		removeChild(tree, n, ref, key[depth], child);
+		return l;
+	}
+	return deleteRecursive(tree, *child, child, key, keyLength, depth + 1);
+}
+
+/*
+ * closest leaf after (forward) or before the key, the key itself counts when inclusive
+ */
+static ArtLeaf *neighborLeaf (ArtNode *n, unsigned char *key, int keyLength, int depth, int forward, int inclusive)
+{
+	ArtLeaf *l, *prefixLeaf = NULL;
+	ArtNode **child;
+	ArtNode *sibling;
+	unsigned char b;
+	int i, cmp;
+
+	if(n == NULL)
+		return NULL;
+
+	if(n->type == ART_LEAF)
+	{
+		l = (ArtLeaf*)n;
+		cmp = compareLeaf(l, key, keyLength);
+		if(forward)
+			return (cmp > 0 || (inclusive && cmp == 0)) ? l : NULL;
+		return (cmp < 0 || (inclusive && cmp == 0)) ? l : NULL;
+	}
+
+	//the whole subtree is either before or after the key unless the path matches
+	if(n->prefixLength > ART_MAX_PREFIX)
+		prefixLeaf = minimumLeaf(n);
+	for(i = 0; i < n->prefixLength; i++)
+	{
+		if(depth + i >= keyLength)
+			return forward ? minimumLeaf(n) : NULL;
+		b = (i < ART_MAX_PREFIX) ? n->prefix[i] : prefixLeaf->key[depth + i];
+		if(b > key[depth + i])
+			return forward ? minimumLeaf(n) : NULL;
+		if(b < key[depth + i])
+			return forward ? NULL : maximumLeaf(n);
+	}
+	depth += n->prefixLength;
+	if(depth >= keyLength)
+		return forward ? minimumLeaf(n) : NULL;
+
+	child = findChild(n, key[depth]);
+	if(child != NULL)
+	{
+		l = neighborLeaf(*child, key, keyLength, depth + 1, forward, inclusive);
+		if(l != NULL)
+			return l;
+	}
+
+	sibling = forward ? nextChild(n, key[depth]) : prevChild(n, key[depth]);
+	if(sibling == NULL)
+		return NULL;
+	return forward ? minimumLeaf(sibling) : maximumLeaf(sibling);
+}
+
+static void freeRecursive (ArtNode *n, void (*freeValue) (void *value))
+{
+	int i;
+
+	if(n == NULL)
+		return;
+
+	switch(n->type)
+	{
+	case ART_LEAF:
+		if(freeValue != NULL)
+			freeValue(((ArtLeaf*)n)->value);
+		break;
+	case ART_NODE4:
+		for(i = 0; i < n->numOfChildren; i++)
+			freeRecursive(((ArtNode4*)n)->children[i], freeValue);
+		break;
+	case ART_NODE16:
+		for(i = 0; i < n->numOfChildren; i++)
+			freeRecursive(((ArtNode16*)n)->children[i], freeValue);
+		break;
+	case ART_NODE48:
+		for(i = 0; i < 48; i++)
+			freeRecursive(((ArtNode48*)n)->children[i], freeValue);
+		break;
+	default:
+		for(i = 0; i < 256; i++)
+			freeRecursive(((ArtNode256*)n)->children[i], freeValue);
+		break;
+	}
+	free(n);
+}
+
+/*
+ * create an empty tree
+ */
+ArtTree *artCreate (void)
+{
+	return (ArtTree*)calloc(1, sizeof(ArtTree));
+}
+
+/*
+ * free the tree, handing every stored value to freeValue
+ */
+void artFree (ArtTree *tree, void (*freeValue) (void *value))
+{
+	if(tree == NULL)
+		return;
+	freeRecursive(tree->root, freeValue);
+	free(tree);
+}
+
+/*
+ * value stored under the key or NULL
+ */
+void *artSearch (ArtTree *tree, unsigned char *key, int keyLength)
+{
+	ArtNode *n = tree->root;
+	ArtNode **child;
+	int depth = 0;
+
+	while(n != NULL)
+	{
+		if(n->type == ART_LEAF)
+			return leafMatches((ArtLeaf*)n, key, keyLength) ? ((ArtLeaf*)n)->value : NULL;
+
+		//only the stored part of the path is compared, the leaf check catches the rest
+		if(n->prefixLength)
+		{
+			if(checkPrefix(n, key, keyLength, depth) != ART_MIN(ART_MAX_PREFIX, n->prefixLength))
+				return NULL;
+			depth += n->prefixLength;
+		}
+		if(depth >= keyLength)
+			return NULL;
+
+		child = findChild(n, key[depth]);
+		n = (child != NULL) ? *child : NULL;
+		depth++;
+	}
+	return NULL;
+}
+
+/*
+ * insert the key, returns 0 and leaves the tree unchanged if it is already there
+ */
+int artInsert (ArtTree *tree, unsigned char *key, int keyLength, void *value)
+{
+	if(!insertRecursive(tree, tree->root, &tree->root, key, keyLength, value, 0))
+		return 0;
+	tree->numOfKeys++;
+	return 1;
+}
+
+/*
+ * remove the key and return its value, NULL if it is not there
+ */
+void *artDelete (ArtTree *tree, unsigned char *key, int keyLength)
+{
+	ArtLeaf *l = deleteRecursive(tree, tree->root, &tree->root, key, keyLength, 0);
+	void *value;
+
+	if(l == NULL)
+		return NULL;
+	value = l->value;
+	free(l);
+	tree->numOfKeys--;
+	return value;
+}
+
+/*
+ * place the cursor before the first key or after the last one
+ */
+void artCursorInit (ArtCursor *cursor, ArtTree *tree, int atEnd)
+{
+	cursor->tree = tree;
+	cursor->key = NULL;
+	cursor->keyLength = 0;
+	cursor->afterKey = 0;
+	cursor->atEnd = atEnd;
+}
+
+/*
+ * move the cursor over the given leaf, or to the end if there is none
+ */
+static void *moveCursor (ArtCursor *cursor, ArtLeaf *l, int forward)
+{
+	free(cursor->key);
+	cursor->key = NULL;
+
+	if(l == NULL)
+	{
+		cursor->atEnd = forward;
+		return NULL;
+	}
+
+	//keep a copy of the key, the leaf may be deleted while the cursor is open
+	cursor->key = (unsigned char*)malloc(l->keyLength);
+	memcpy(cursor->key, l->key, l->keyLength);
+	cursor->keyLength = l->keyLength;
+	cursor->afterKey = forward;
+	return l->value;
+}
+
+void *artCursorNext (ArtCursor *cursor)
+{
+	ArtLeaf *l;
+
+	if(cursor->key == NULL)
+		l = cursor->atEnd ? NULL : minimumLeaf(cursor->tree->root);
+	else
+		l = neighborLeaf(cursor->tree->root, cursor->key, cursor->keyLength, 0, 1, !cursor->afterKey);
+	return moveCursor(cursor, l, 1);
+}
+
+void *artCursorPrev (ArtCursor *cursor)
+{
+	ArtLeaf *l;
+
+	if(cursor->key == NULL)
+		l = cursor->atEnd ? maximumLeaf(cursor->tree->root) : NULL;
+	else
+		l = neighborLeaf(cursor->tree->root, cursor->key, cursor->keyLength, 0, 0, cursor->afterKey);
+	return moveCursor(cursor, l, 0);
+}
+
+void artCursorClose (ArtCursor *cursor)
+{
+	free(cursor->key);
+	cursor->key = NULL;
+}
@@ -0,0 +1,39 @@
+#ifndef ART_INDEX_H
+#define ART_INDEX_H
+
+// Adaptive Radix Tree over binary comparable keys
+// keys must be prefix free i.e. no key is a prefix of another key
+
+typedef struct ArtNode ArtNode;
+
+typedef struct ArtTree {
+  ArtNode *root;
+  int numOfKeys;	// number of leaves
+  int numOfNodes;	// number of inner nodes
+} ArtTree;
+
+// cursor sitting between two keys, like the cursor of a tree scan
+typedef struct ArtCursor {
+  ArtTree *tree;
+  unsigned char *key;	// key next to the cursor, NULL at either end
+  int keyLength;
+  int afterKey;		// cursor sits after key (1) or before it (0)
+  int atEnd;		// without a key: after the last key (1) or before the first (0)
+} ArtCursor;
+
+// create and destroy
+extern ArtTree *artCreate (void);
+extern void artFree (ArtTree *tree, void (*freeValue) (void *value));
+
+// point access, artInsert returns 0 when the key already exists
+extern void *artSearch (ArtTree *tree, unsigned char *key, int keyLength);
+extern int artInsert (ArtTree *tree, unsigned char *key, int keyLength, void *value);
+extern void *artDelete (ArtTree *tree, unsigned char *key, int keyLength);
+
+// ordered access
+extern void artCursorInit (ArtCursor *cursor, ArtTree *tree, int atEnd);
+extern void *artCursorNext (ArtCursor *cursor);
+extern void *artCursorPrev (ArtCursor *cursor);
+extern void artCursorClose (ArtCursor *cursor);
+
+#endif // ART_INDEX_H
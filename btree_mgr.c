@@ -5,11 +5,15 @@
 #include "stdio.h"
 #include "stdlib.h"
 #include "string.h"
+#include "float.h"
 #include "btree_mgr.h"
 #include "record_mgr.h"
 #include "storage_mgr.h"
 #include "buffer_mgr.h"
 #include "tables.h"
+#include "art_index.h"
+#include "hash_index.h"
+#include "frozen_index.h"
 
 
 //Structure for BTree Representation
@@ -17,593 +21,4642 @@ typedef struct BTree
 {
 	struct Value value;
 	struct RID rid;
-	int numOfKeys;
+	int numOfKeys;				//number of entries of the index
+	struct BTree **entries;		//entries of the index in key order
+	int allocatedKeys;			//number of entry slots allocated in entries
+	ArtTree *art;				//keys of an index served by the ART engine, the tree leaves point to BTree entries
+	int numOfLeafPages;			//pages of the leaf level written to the index file
+	int nodePages;				//pages of a leaf node, a larger entry gets a longer leaf
+	int firstDirtyEntry;		//first entry changed since the leaves were written, -1 if none
 	BM_BufferPool *bm;
 	BM_PageHandle *ph;
 	int maxNumOfKeysPerNode;
 	int nodeCounter;
+	struct BloomFilter *bloom;
+	struct AdaptiveHashIndex *ahi;
+	struct LearnedIndex *learned;
+	struct InterpolationSearch *interpolation;
+	struct EytzingerLayout *eytzinger;
+	struct KeyHistogram *histogram;
+	struct MessageBuffer *buffer;
+	Value **payload;			//included columns stored with an entry
+	int numOfIncluded;			//number of included columns of the index
+	DataType *includedTypes;	//datatypes of the included columns
+	IndexEngine engine;			//engine serving the index
+	HashIndex *hash;			//pages of the extendible hash engine
+	FrozenIndex *frozen;		//mapping of a frozen export
+	struct EntryVersions *versions;	//copy-on-write versions of the entries
+	struct EntryBlock *block;	//block holding the entry after a defragmentation, NULL if allocated alone
+	struct KVValue *kv;			//value stored with the key by kvPut, NULL for an index entry
+	struct OverflowStore *overflow;	//overflow pages of the large values of the tree
+	char *fileName;				//index file, every handle opened on it shares the tree
+	DataType keyType;			//datatype of the keys, given to the handles opened later
+	int openHandles;			//handles of the tree not closed yet
+	struct BTree *nextOpen;		//next tree in the list of open trees
+	int tableAttr;				//attribute of the table the keys come from, -1 for an index not built on a table
+	Expr *cond;					//rows of a partial index, NULL for every row
 }BTree;
 
+//Block of memory holding entries packed in key order by defragmentBtree,
+//their keys and payloads included. It is freed with its last entry
+typedef struct EntryBlock
+{
+	int liveEntries;
+	char *memory;
+}EntryBlock;
 
-BTree **AllocBTree;
+//Value of a key-value entry: up to BT_KV_INLINE_MAX bytes are stored inline behind it,
+//a larger value lives in a chain of overflow pages starting at firstPage
+typedef struct KVValue
+{
+	int length;
+	int firstPage;		//NO_PAGE for an inline value
+	char data[1];
+}KVValue;
 
+//Page file holding the overflow pages of an index, opened when a large value is first used.
+//Freed pages are chained into a free list and reused once no snapshot can read them
+typedef struct OverflowStore
+{
+	char *fileName;
+	BM_BufferPool *bm;
+	BM_PageHandle *ph;
+	int numOfPages;		//pages of the file, the meta page included
+	int freeHead;		//first free page, NO_PAGE if there is none
+}OverflowStore;
 
-//Store the Number of Keys allocated in B+Tree
-int numOfKeys;
-int scanNextEntry;
+//Structure for the optional Bloom filter of an index
+//the filter is split in blocks of one cache line, every key sets all its bits in a single block
+typedef struct BloomFilter
+{
+	int bitsPerKey;			//configured number of bits per key
+	int numOfHashes;		//number of bits set per key inside its block
+	int numOfBlocks;		//number of BT_BLOOM_BLOCK_SIZE byte blocks
+	int capacity;			//number of keys the filter was sized for
+	unsigned char *bits;
+}BloomFilter;
+
+//Slot of the adaptive hash index, remembers where a hot key was last found
+typedef struct AdaptiveHashSlot
+{
+	unsigned long long hash;	//hash of the key owning the slot
+	int position;				//position of the key in the entries
+	int hits;					//number of lookups of the key since it owns the slot
+	int generation;				//generation in which position was recorded
+}AdaptiveHashSlot;
+
+//Structure for the adaptive hash index of an index, a direct mapped table of hot keys
+//generation is bumped whenever entries move, which invalidates every recorded position
+typedef struct AdaptiveHashIndex
+{
+	int generation;
+	AdaptiveHashSlot slots[1];
+}AdaptiveHashIndex;
+
+//Segment of the learned index, a linear model of the positions of the keys from firstKey on
+typedef struct LearnedSegment
+{
+	int firstKey;
+	int position;		//position of firstKey in the entries
+	double slope;		//predicted positions per key value
+}LearnedSegment;
+
+//Structure for the learned index of a DT_INT index: piecewise linear models over the
+//sorted keys that predict the position of every key at most maxError entries off.
+//It is stale after the entries changed and rebuilt once enough lookups paid for it
+typedef struct LearnedIndex
+{
+	int maxError;
+	int numOfSegments;
+	LearnedSegment *segments;
+	bool valid;
+	int staleLookups;	//lookups answered without the model since it became stale
+}LearnedIndex;
+
+//State of the interpolation search of a DT_INT index. It is used while a sample of the keys
+//looks uniform, after the entries changed the sample is taken again once enough lookups came by
+typedef struct InterpolationSearch
+{
+	bool uniform;		//verdict of the last sample
+	bool valid;			//no entry changed since the sample
+	int staleLookups;	//lookups since the entries changed
+}InterpolationSearch;
+
+//Read-only copy of the keys in Eytzinger (breadth first) order: slot k has its children at
+//2k and 2k + 1, so a search walks down from slot 1 without branching on the comparisons and
+//the slots of the next levels are prefetched. It is stale after a write and rebuilt
+//once enough lookups paid for it, like the learned index
+typedef struct EytzingerLayout
+{
+	int numOfSlots;
+	Value *slots;		//keys from slot 1 on, string keys point into the entries
+	int *positions;		//position in the entries of the key of every slot
+	bool valid;
+	int staleLookups;	//lookups answered without the layout since it became stale
+}EytzingerLayout;
+
+//Equi-depth histogram of the keys for estimateRangeCount. Bucket b holds the keys from
+//bounds[b] up to bounds[b + 1], the bounds are separator keys of the leaf level, so every
+//bucket starts with the same number of leaves. The counts follow every insert and delete,
+//the bounds are taken again after enough changes
+typedef struct KeyHistogram
+{
+	int numOfBuckets;
+	Value *bounds;		//numOfBuckets + 1 copies of keys, the last one is the largest key
+	int *counts;		//keys in every bucket
+	int numOfKeys;		//keys in all buckets
+	int changes;		//inserts and deletes since the bounds were taken
+}KeyHistogram;
+
+//Message of the write buffer, an insert or delete that was not applied to the entries yet
+typedef struct BTreeMessage
+{
+	int type;			//BT_MSG_INSERT or BT_MSG_DELETE
+	BTree *entry;		//entry to insert, or only the key to delete
+}BTreeMessage;
+
+//Structure for the write buffer (delta) of an index in write buffering mode,
+//it holds at most one message per key in key order and is merged into the entries when it fills
+typedef struct MessageBuffer
+{
+	int capacity;
+	int count;
+	BTreeMessage *messages;
+}MessageBuffer;
+
+//Version of the entries pinned by snapshot scans, kept until its last scan is closed
+typedef struct EntrySnapshot
+{
+	BTree **entries;		//array of the version, still the entries of the tree while the version is current
+	int numOfKeys;
+	int readers;			//open scans of the version
+	BTree **retired;		//entries removed while the version was the newest one
+	int numOfRetired;
+	int retiredCapacity;
+	struct EntrySnapshot *next;	//next newer snapshot
+}EntrySnapshot;
+
+//Copy-on-write state of an index: a writer never changes an array pinned by a snapshot,
+//it works on a copy and publishes it as the next version of the entries
+typedef struct EntryVersions
+{
+	bool enabled;			//scans pin a snapshot instead of reading the live entries
+	int version;			//version of the current entries, stored in the header page
+	EntrySnapshot *oldest;
+	EntrySnapshot *newest;
+	EntrySnapshot *current;	//snapshot of the current version, if a scan pinned it
+}EntryVersions;
+
+//Structure for the position of a tree scan, the cursor sits between two entries:
+//nextEntry returns the entry after it and prevEntry the entry before it.
+//The scan reads the entries and the write buffer together, so it has a position in both
+typedef struct BT_ScanMgmt
+{
+	int cursor;			//position in the entries
+	int deltaCursor;	//position in the write buffer
+	ArtCursor artCursor;	//position of a scan over the ART engine
+	BTree frozenEntry;		//entry of a frozen export last returned by the scan
+	EntrySnapshot *snapshot;	//version read by a copy-on-write scan, NULL for a live scan
+	int prefetchDirection;	//direction the prefetches run in, 0 before the first entry
+	int prefetchWindow;	//number of entries prefetched ahead of the cursor
+	int prefetchEnd;		//first position not prefetched yet in that direction
+}BT_ScanMgmt;
+
+//Structure used to sort the keys of a batch insert before merging them
+typedef struct BTreeBatchEntry
+{
+	Value *key;
+	RID rid;
+	Value **payload;	//included values of the entry, NULL if it has none
+}BTreeBatchEntry;
+
+//Keys and RIDs collected by the table scan of createIndexOnTable
+typedef struct TableIndexBuild
+{
+	Value **keys;
+	RID *rids;
+	int count;
+	int capacity;
+}TableIndexBuild;
+
+//Page 0 of the index file stores N, the key type, the number of entries, the engine,
+//the version of the entries last published by a writer and the pages of the leaf level
+#define BT_HEADER_PAGE 0
+#define BT_HEADER_N 0
+#define BT_HEADER_KEYTYPE 1
+#define BT_HEADER_ENTRIES 2
+#define BT_HEADER_BLOOM_BITS 3
+#define BT_HEADER_BLOOM_BLOCKS 4
+#define BT_HEADER_ENGINE 5
+#define BT_HEADER_VERSION 6
+#define BT_HEADER_INCLUDED 7
+#define BT_HEADER_INCLUDED_TYPES 8
+#define BT_HEADER_LEAF_PAGES (BT_HEADER_INCLUDED_TYPES + BT_MAX_INCLUDED)
+#define BT_HEADER_NODE_PAGES (BT_HEADER_LEAF_PAGES + 1)
+
+//An index built on a table also stores the attribute of its keys and the condition
+//of a partial index, the expression in prefix order filling the rest of the header page
+#define BT_HEADER_TABLE_ATTR (BT_HEADER_NODE_PAGES + 1)
+#define BT_HEADER_COND_BYTES (BT_HEADER_NODE_PAGES + 2)
+#define BT_HEADER_COND (BT_HEADER_NODE_PAGES + 3)
+#define BT_COND_MAX_BYTES (PAGE_SIZE - BT_HEADER_COND * (int)sizeof(int))
+
+//Largest node of createBtreeWithNodeSize (64 KB) and the bytes of a key slot in a node
+#define BT_MAX_NODE_PAGES 16
+#define BT_NODE_SLOT_SIZE ((int)(sizeof(Value) + sizeof(RID)))
+
+//Maximum number of included (covering) columns of an index
+#define BT_MAX_INCLUDED 64
+
+//The entries are written in key order to the leaf pages following the header page.
+//A leaf starts with its number of entries and of pages and holds as many entries
+//as fit into a node of nodePages pages, an entry larger than a node gets a longer leaf
+#define BT_LEAF_FIRST_PAGE 1
+#define BT_LEAF_ENTRIES 0
+#define BT_LEAF_PAGES 1
+#define BT_LEAF_HEADER_SIZE ((int)(2 * sizeof(int)))
+
+//The Bloom filter blocks are stored on the pages following the leaves
+#define BT_BLOOM_BLOCK_SIZE 64
+#define BT_BLOOM_BLOCK_BITS (BT_BLOOM_BLOCK_SIZE * 8)
+#define BT_BLOOM_BLOCKS_PER_PAGE (PAGE_SIZE / BT_BLOOM_BLOCK_SIZE)
+
+//The extendible hash engine keeps its meta page there instead, it has no leaves and no Bloom filter
+#define BT_HASH_META_PAGE 1
+
+//Size of the adaptive hash index and number of lookups before a key is hashed
+#define BT_AHI_SLOTS 1024
+#define BT_AHI_THRESHOLD 4
+
+//A stale learned index is rebuilt after numOfKeys / BT_LEARNED_REBUILD_DIVISOR lookups
+#define BT_LEARNED_REBUILD_DIVISOR 16
+
+//Interpolation search takes at most BT_INTERPOLATION_STEPS probes before it falls back to
+//binary search. It is used while the keys at BT_INTERPOLATION_SAMPLES evenly spaced positions
+//are at most numOfKeys / BT_INTERPOLATION_SKEW positions off the straight line from the
+//smallest to the largest key, the sample is renewed BT_INTERPOLATION_RESAMPLE lookups after a write
+#define BT_INTERPOLATION_STEPS 3
+#define BT_INTERPOLATION_SAMPLES 32
+#define BT_INTERPOLATION_SKEW 16
+#define BT_INTERPOLATION_RESAMPLE 16
+
+//Slots prefetched ahead by an Eytzinger search: the 16 descendants of slot k four levels down
+//start at slot 16k. Near the bottom of the layout they lie past the last slot,
+//the prefetch then stays on the last slot so no pointer leaves the array
+#define BT_EYTZINGER_PREFETCH 16
+#define BT_EYTZINGER_PREFETCH_SLOT(k, numOfSlots)	\
+	(((k) <= (numOfSlots) / BT_EYTZINGER_PREFETCH) ? BT_EYTZINGER_PREFETCH * (k) : (numOfSlots))
+
+//The key histogram has at most BT_HISTOGRAM_BUCKETS buckets, its bounds are taken again
+//once the inserts and deletes reach its number of keys / BT_HISTOGRAM_REBUILD_DIVISOR
+#define BT_HISTOGRAM_BUCKETS 64
+#define BT_HISTOGRAM_REBUILD_DIVISOR 4
+
+//defragmentBtree fills this percentage of the entry array, the rest is left to inserts
+#define BT_DEFRAG_FILL 90
+
+//Prefetch window of the scans in entries, it doubles up to the maximum while a scan keeps going.
+//The entries are in memory, so a scan only prefetches them into the CPU cache.
+//A frozen export has the kernel read ahead up to BT_PREFETCH_FROZEN_BYTES of its mapping
+#define BT_PREFETCH_MIN 4
+#define BT_PREFETCH_MAX 64
+#define BT_PREFETCH_FROZEN_BYTES (256 * 1024)
+
+//Hint the CPU to load an entry into the cache, other compilers go without the hint
+#ifdef __GNUC__
+#define BT_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define BT_PREFETCH(address)
+#endif
+
+//Values up to this size are stored inline in their entry, larger ones in overflow pages.
+//The overflow file is the index file with BT_OVERFLOW_SUFFIX, its page 0 stores
+//the number of pages and the free list, every other page starts with the next
+//page of its chain and the number of value bytes on it
+#define BT_KV_INLINE_MAX 512
+#define BT_OVERFLOW_SUFFIX ".ovf"
+#define BT_OVERFLOW_META_PAGE 0
+#define BT_OVERFLOW_NEXT 0
+#define BT_OVERFLOW_USED 1
+#define BT_OVERFLOW_HEADER_SIZE ((int)(2 * sizeof(int)))
+#define BT_OVERFLOW_DATA_SIZE (PAGE_SIZE - BT_OVERFLOW_HEADER_SIZE)
+
+//Message types of the write buffer
+#define BT_MSG_INSERT 0
+#define BT_MSG_DELETE 1
+
+
+//Trees opened with openBtree and not closed yet, a second openBtree of the same
+//file gets the same tree, so its handles share the entries and the Bloom filter
+static BTree *openTrees = NULL;
 
-// init and shutdown index manager
 /*
- * This is function is used to Initialize Index Manager
+ * Compare two keys of the same datatype,
+ * returns <0, 0 or >0 like strcmp
  */
-RC initIndexManager (void *mgmtData)
+static int compareKeys (Value *left, Value *right)
 {
-	return RC_OK;
+	switch(left->dt)
+	{
+	case DT_INT:
+		return (left->v.intV > right->v.intV) - (left->v.intV < right->v.intV);
+	case DT_FLOAT:
+		return (left->v.floatV > right->v.floatV) - (left->v.floatV < right->v.floatV);
+	case DT_STRING:
+		return strcmp(left->v.stringV, right->v.stringV);
+	case DT_BOOL:
+		return left->v.boolV - right->v.boolV;
+	case DT_INT64:
+		return (left->v.int64V > right->v.int64V) - (left->v.int64V < right->v.int64V);
+	case DT_DOUBLE:
+		return (left->v.doubleV > right->v.doubleV) - (left->v.doubleV < right->v.doubleV);
+	}
+	return 0;
+}
+
+//Binary search step of searchKeyPosition over a fixed-width key, the field of
+//the entries is compared directly instead of through compareKeys
+#define BT_SEARCH_FIXED(entries, field, target, low, high)		\
+	while(low < high)											\
+	{															\
+		int mid = low + (high - low) / 2;						\
+																\
+		if(entries[mid]->value.v.field < (target))				\
+			low = mid + 1;										\
+		else													\
+			high = mid;											\
+	}
+
+/*
+ * Binary search over the sorted entries,
+ * returns the position of the first entry whose key is >= key
+ * and sets found when that entry holds exactly the key
+ */
+static int searchKeyPosition (BTree *treeInfo, Value *key, int *found)
+{
+	BTree **entries = treeInfo->entries;
+	int low = 0, high = treeInfo->numOfKeys;
+
+	//numeric keys take a search without the datatype switch of compareKeys in every step
+	switch(key->dt)
+	{
+	case DT_INT:
+		BT_SEARCH_FIXED(entries, intV, key->v.intV, low, high);
+		break;
+	case DT_INT64:
+		BT_SEARCH_FIXED(entries, int64V, key->v.int64V, low, high);
+		break;
+	case DT_FLOAT:
+		BT_SEARCH_FIXED(entries, floatV, key->v.floatV, low, high);
+		break;
+	case DT_DOUBLE:
+		BT_SEARCH_FIXED(entries, doubleV, key->v.doubleV, low, high);
+		break;
+	default:
+		while(low < high)
+		{
+			int mid = low + (high - low) / 2;
+
+			if(compareKeys(&entries[mid]->value, key) < 0)
+				low = mid + 1;
+			else
+				high = mid;
+		}
+		break;
+	}
+
+	*found = (low < treeInfo->numOfKeys && compareKeys(&entries[low]->value, key) == 0);
+	return low;
 }
 
 /*
- * This is function is used to shut down the index manager,
- * also free's the memory allocated during the process
+ * Make sure the entries of the tree have room for the required number of entries,
+ * the array grows by doubling so inserts stay amortized O(1) in allocation
  */
+static void ensureKeyCapacity (BTree *treeInfo, int required)
+{
+	if(required <= treeInfo->allocatedKeys)
+		return;
 
-RC shutdownIndexManager()
+	int newSize = (treeInfo->allocatedKeys == 0) ? 16 : treeInfo->allocatedKeys;
+	while(newSize < required)
+		newSize *= 2;
+
+	treeInfo->entries = (BTree**)realloc(treeInfo->entries, sizeof(BTree*) * newSize);
+	treeInfo->allocatedKeys = newSize;
+}
+
+/*
+ * Copy a value into dest, strings are copied so the tree does not depend on the caller's memory
+ */
+static void copyValue (Value *dest, Value *src)
+{
+	dest->dt = src->dt;
+	if(src->dt == DT_STRING)
+	{
+		dest->v.stringV = (char*)malloc(strlen(src->v.stringV) + 1);
+		strcpy(dest->v.stringV, src->v.stringV);
+	}
+	else
+	{
+		dest->v = src->v;
+	}
+}
+
+/*
+ * Allocate a new entry holding a copy of the key, its RID
+ * and the numOfIncluded payload values, if any
+ */
+static BTree *createEntry (Value *key, RID rid, Value **payload, int numOfIncluded)
 {
+	BTree *entry = (BTree*)malloc(sizeof(BTree));
 	int i;
 
-	//for all keys inserted
-	for(i = 0;i<numOfKeys;i++)
+	entry->block = NULL;
+	entry->kv = NULL;
+	copyValue(&entry->value, key);
+	entry->rid.page = rid.page;
+	entry->rid.slot = rid.slot;
+
+	entry->payload = NULL;
+	entry->numOfIncluded = 0;
+	if(payload != NULL && numOfIncluded > 0)
 	{
-		free(AllocBTree[numOfKeys]);
+		entry->numOfIncluded = numOfIncluded;
+		entry->payload = (Value**)malloc(sizeof(Value*) * numOfIncluded);
+		for(i = 0;i<numOfIncluded;i++)
+		{
+			entry->payload[i] = (Value*)malloc(sizeof(Value));
+			copyValue(entry->payload[i], payload[i]);
+		}
 	}
-	return RC_OK;
+
+	return entry;
 }
 
-// create, destroy, open, and close an btree index
+/*
+ * Free an entry, its string key, its payload and its value, if any
+ */
+static void freeEntry (BTree *entry)
+{
+	int i;
+
+	free(entry->kv);
+
+	//a packed entry only goes away with the last entry of its block
+	if(entry->block != NULL)
+	{
+		EntryBlock *block = entry->block;
+
+		if(--block->liveEntries == 0)
+		{
+			free(block->memory);
+			free(block);
+		}
+		return;
+	}
+
+	if(entry->value.dt == DT_STRING)
+		free(entry->value.v.stringV);
+	for(i = 0;i<entry->numOfIncluded;i++)
+		freeVal(entry->payload[i]);
+	free(entry->payload);
+	free(entry);
+}
 
 /*
- * This function is used to Create A B+ Tree
- * all the attributes related to the tree are initialized
+ * Free all the entries of the tree and reset the counters
  */
-RC createBtree (char *idxId, DataType keyType, int n)
+static void freeAllEntries (BTree *treeInfo)
 {
-	SM_FileHandle fh;
-	SM_PageHandle ph = malloc(PAGE_SIZE*sizeof(char));
+	int i;
 
-	//Create a B-tree, using page file
-	createPageFile(idxId);
+	for(i = 0;i<treeInfo->numOfKeys;i++)
+	{
+		freeEntry(treeInfo->entries[i]);
+	}
+	free(treeInfo->entries);
+	treeInfo->entries = NULL;
+	treeInfo->allocatedKeys = 0;
+	treeInfo->numOfKeys = 0;
+}
 
-	openPageFile(idxId,&fh);
+/*
+ * Record the current number of entries and their version in the header page,
+ * the caller decides how often this happens, so a batch pays for a single pin
+ */
+static void writeHeaderEntries (BTree *treeInfo)
+{
+	pinPage(treeInfo->bm,treeInfo->ph,BT_HEADER_PAGE);
+	((int*)treeInfo->ph->data)[BT_HEADER_ENTRIES] = treeInfo->numOfKeys;
+	((int*)treeInfo->ph->data)[BT_HEADER_VERSION] = treeInfo->versions->version;
+	markDirty(treeInfo->bm,treeInfo->ph);
+	unpinPage(treeInfo->bm,treeInfo->ph);
+}
 
-	//confirm the number of pages present
-	ensureCapacity(1,&fh);
+/*
+ * Remember the first entry that changed since the leaves were written,
+ * the leaves in front of it are still up to date in the index file
+ */
+static void markEntriesDirty (BTree *treeInfo, int pos)
+{
+	if(treeInfo->firstDirtyEntry < 0 || pos < treeInfo->firstDirtyEntry)
+		treeInfo->firstDirtyEntry = pos;
+}
 
-	//Allocate Memory for the Btree
-	AllocBTree = (BTree**)malloc(sizeof(BTree*));
+/*
+ * Pin the current version of the entries for a scan,
+ * scans opened between two writes share one snapshot
+ */
+static EntrySnapshot *pinSnapshot (BTree *treeInfo)
+{
+	EntryVersions *versions = treeInfo->versions;
+	EntrySnapshot *snapshot = versions->current;
 
-	//Update all the BTree Handle attributes
-	BTreeHandle *btHandle = (BTreeHandle*)malloc(sizeof(BTreeHandle*));
-	btHandle->idxId = idxId;
-	btHandle->keyType = keyType;
-	btHandle->mgmtData = n;
+	if(snapshot == NULL)
+	{
+		snapshot = (EntrySnapshot*)calloc(1, sizeof(EntrySnapshot));
+		snapshot->entries = treeInfo->entries;
+		snapshot->numOfKeys = treeInfo->numOfKeys;
+		if(versions->newest != NULL)
+			versions->newest->next = snapshot;
+		else
+			versions->oldest = snapshot;
+		versions->newest = snapshot;
+		versions->current = snapshot;
+	}
 
-	//this page will have the number of keys that can be inserted into a single Node
-	*((int*)ph)=n;
+	snapshot->readers++;
+	return snapshot;
+}
 
-	//write the value of N to the page
-	writeCurrentBlock(&fh,ph);
+/*
+ * Free a snapshot, its array unless it is still the current one, and its retired entries
+ */
+static void freeSnapshot (EntryVersions *versions, EntrySnapshot *snapshot)
+{
+	int i;
 
-	closePageFile(&fh);
+	if(snapshot == versions->current)
+		versions->current = NULL;
+	else
+		free(snapshot->entries);
 
-	//Initialize the Num of Keys to 0
-	numOfKeys = 0;
-	scanNextEntry = 0;
+	for(i = 0;i<snapshot->numOfRetired;i++)
+		freeEntry(snapshot->retired[i]);
+	free(snapshot->retired);
+	free(snapshot);
+}
 
-	return RC_OK;
+/*
+ * Release the snapshot of a closed scan. Snapshots are freed oldest first:
+ * an entry retired while a snapshot was the newest is still in the older ones
+ */
+static void releaseSnapshot (BTree *treeInfo, EntrySnapshot *snapshot)
+{
+	EntryVersions *versions = treeInfo->versions;
+
+	snapshot->readers--;
+	while(versions->oldest != NULL && versions->oldest->readers == 0)
+	{
+		EntrySnapshot *oldest = versions->oldest;
+
+		versions->oldest = oldest->next;
+		if(versions->oldest == NULL)
+			versions->newest = NULL;
+		freeSnapshot(versions, oldest);
+	}
 }
 
 /*
- * This function is used to open the B-Tree alread created above,
- * it read the value from the page file regarding the "N"
- * and stores in the BTREE structure created attributes
+ * Free every snapshot when the tree is closed, scans still open on it cannot be used anymore
  */
-RC openBtree (BTreeHandle **tree, char *idxId)
+static void freeEntryVersions (BTree *treeInfo)
 {
-	SM_FileHandle fh;
+	EntryVersions *versions = treeInfo->versions;
 
-	//Open a PageFile
-	openPageFile(idxId,&fh);
+	while(versions->oldest != NULL)
+	{
+		EntrySnapshot *oldest = versions->oldest;
 
-	//Create a Btree Handler
-	*tree = (BTreeHandle*)malloc(sizeof(BTreeHandle));
+		versions->oldest = oldest->next;
+		freeSnapshot(versions, oldest);
+	}
+	free(versions);
+	treeInfo->versions = NULL;
+}
 
-	//(*tree)->idxId =(char*)malloc(sizeof(char));
-	(*tree)->idxId = idxId;
+/*
+ * Start a new version of the entries before a writer changes them.
+ * When a scan pinned the current version its array is left alone:
+ * copy makes the entries of the tree a private copy to change in place, without it
+ * the writer builds a new array itself and must not free the old one.
+ * returns TRUE when the old array belongs to a snapshot now
+ */
+static bool detachCurrentVersion (BTree *treeInfo, bool copy)
+{
+	EntryVersions *versions = treeInfo->versions;
 
-	//Create a Tree Information Node
-	BTree *treeInfo = (BTree*)malloc(sizeof(BTree));
+	versions->version++;
+	if(versions->current == NULL)
+		return FALSE;
 
-	//Make Buffer Pool & Page Handle to access the pages
-	treeInfo->bm = MAKE_POOL();
-	treeInfo->ph = MAKE_PAGE_HANDLE();
+	versions->current = NULL;
+	if(copy)
+	{
+		BTree **entries = (BTree**)malloc(sizeof(BTree*) * (treeInfo->allocatedKeys + 1));
 
-	//initialize the Buffer Pool
-	initBufferPool(treeInfo->bm,idxId,6,RS_FIFO,NULL);
+		memcpy(entries, treeInfo->entries, sizeof(BTree*) * treeInfo->numOfKeys);
+		treeInfo->entries = entries;
+	}
+	return TRUE;
+}
+
+/*
+ * Publish a new array of entries built by a merge,
+ * the old array is freed unless a snapshot still reads it
+ */
+static void replaceEntries (BTree *treeInfo, BTree **entries, int count, int capacity)
+{
+	if(!detachCurrentVersion(treeInfo, FALSE))
+		free(treeInfo->entries);
+	treeInfo->entries = entries;
+	treeInfo->allocatedKeys = capacity;
+	treeInfo->numOfKeys = count;
+}
+
+/*
+ * Free an entry removed from the tree, or hand it to the newest snapshot
+ * when one exists, the snapshots may still return it to their scans
+ */
+static void retireEntry (BTree *treeInfo, BTree *entry)
+{
+	EntrySnapshot *newest = treeInfo->versions->newest;
+
+	if(newest == NULL)
+	{
+		freeEntry(entry);
+		return;
+	}
+
+	if(newest->numOfRetired == newest->retiredCapacity)
+	{
+		newest->retiredCapacity = (newest->retiredCapacity == 0) ? 16 : newest->retiredCapacity * 2;
+		newest->retired = (BTree**)realloc(newest->retired, sizeof(BTree*) * newest->retiredCapacity);
+	}
+	newest->retired[newest->numOfRetired++] = entry;
+}
+
+/*
+ * Number of bytes of the strings of a value, 0 for the other datatypes
+ */
+static size_t stringBytes (Value *value)
+{
+	return (value->dt == DT_STRING) ? strlen(value->v.stringV) + 1 : 0;
+}
+
+/*
+ * Copy a value into a packed block, a string goes to *chars
+ */
+static void packValue (Value *dest, Value *src, char **chars)
+{
+	dest->dt = src->dt;
+	dest->v = src->v;
+	if(src->dt == DT_STRING)
+	{
+		strcpy(*chars, src->v.stringV);
+		dest->v.stringV = *chars;
+		*chars += strlen(src->v.stringV) + 1;
+	}
+}
+
+/*
+ * Copy the value of a key-value entry, an overflow value shares its pages with the original
+ */
+static KVValue *copyKVValue (KVValue *kv)
+{
+	KVValue *copy;
+	size_t size;
+
+	if(kv == NULL)
+		return NULL;
+
+	size = sizeof(KVValue) + ((kv->firstPage == NO_PAGE) ? kv->length : 0);
+	copy = (KVValue*)malloc(size);
+	memcpy(copy, kv, size);
+	return copy;
+}
+
+/*
+ * Copy count entries into one block of memory in the same order:
+ * first the entries, then the payload pointers, the payload values and the strings.
+ * A scan of the copies reads the block sequentially instead of
+ * jumping between allocations made in insertion order.
+ * returns the array of the copies with room for capacity entries
+ */
+static BTree **packEntries (BTree **entries, int count, int capacity)
+{
+	EntryBlock *block;
+	BTree **packed = (BTree**)malloc(sizeof(BTree*) * capacity);
+	BTree *copies;
+	Value **payloadPointers;
+	Value *payloadValues;
+	char *chars;
+	size_t numOfPayloads = 0, numOfChars = 0;
+	int i, j;
+
+	if(count == 0)
+		return packed;
+
+	for(i = 0;i<count;i++)
+	{
+		numOfChars += stringBytes(&entries[i]->value);
+		numOfPayloads += entries[i]->numOfIncluded;
+		for(j = 0;j<entries[i]->numOfIncluded;j++)
+			numOfChars += stringBytes(entries[i]->payload[j]);
+	}
+
+	block = (EntryBlock*)malloc(sizeof(EntryBlock));
+	block->liveEntries = count;
+	block->memory = (char*)malloc(sizeof(BTree) * count + (sizeof(Value*) + sizeof(Value)) * numOfPayloads + numOfChars);
+	copies = (BTree*)block->memory;
+	payloadPointers = (Value**)(copies + count);
+	payloadValues = (Value*)(payloadPointers + numOfPayloads);
+	chars = (char*)(payloadValues + numOfPayloads);
+
+	for(i = 0;i<count;i++)
+	{
+		BTree *copy = &copies[i];
+
+		copy->block = block;
+		copy->kv = copyKVValue(entries[i]->kv);
+		copy->rid = entries[i]->rid;
+		packValue(&copy->value, &entries[i]->value, &chars);
+
+		copy->numOfIncluded = entries[i]->numOfIncluded;
+		copy->payload = NULL;
+		if(copy->numOfIncluded > 0)
+		{
+			copy->payload = payloadPointers;
+			for(j = 0;j<copy->numOfIncluded;j++)
+			{
+				copy->payload[j] = payloadValues++;
+				packValue(copy->payload[j], entries[i]->payload[j], &chars);
+			}
+			payloadPointers += copy->numOfIncluded;
+		}
+		packed[i] = copy;
+	}
+	return packed;
+}
+
+/*
+ * Name of the overflow file of an index, the caller frees it
+ */
+static char *overflowFileName (char *idxId)
+{
+	char *fileName = (char*)malloc(strlen(idxId) + strlen(BT_OVERFLOW_SUFFIX) + 1);
+
+	sprintf(fileName, "%s%s", idxId, BT_OVERFLOW_SUFFIX);
+	return fileName;
+}
+
+/*
+ * Remove the overflow file of an index together with its entries, if it has one
+ */
+static void destroyOverflowFile (char *idxId)
+{
+	char *fileName = overflowFileName(idxId);
+
+	destroyPageFile(fileName);
+	free(fileName);
+}
+
+/*
+ * Open the overflow pages of the tree, the file is created with the first large value.
+ * returns NULL if the file cannot be created
+ */
+static OverflowStore *getOverflowStore (BTree *treeInfo)
+{
+	OverflowStore *store;
+	SM_FileHandle fh;
+	char *fileName;
+
+	if(treeInfo->overflow != NULL)
+		return treeInfo->overflow;
+
+	fileName = overflowFileName(treeInfo->bm->pageFile);
+	if(openPageFile(fileName,&fh) == RC_OK)
+		closePageFile(&fh);
+	else if(createPageFile(fileName) != RC_OK)
+	{
+		free(fileName);
+		return NULL;
+	}
+
+	store = (OverflowStore*)malloc(sizeof(OverflowStore));
+	store->fileName = fileName;
+	store->bm = MAKE_POOL();
+	store->ph = MAKE_PAGE_HANDLE();
+	initBufferPool(store->bm,fileName,6,RS_FIFO,NULL);
+
+	//a new file has an empty meta page
+	pinPage(store->bm,store->ph,BT_OVERFLOW_META_PAGE);
+	store->numOfPages = ((int*)store->ph->data)[0];
+	store->freeHead = ((int*)store->ph->data)[1];
+	if(store->numOfPages == 0)
+	{
+		store->numOfPages = 1;
+		store->freeHead = NO_PAGE;
+	}
+	unpinPage(store->bm,store->ph);
+
+	treeInfo->overflow = store;
+	return store;
+}
+
+/*
+ * Write the meta page and close the overflow pages of the tree, if they were opened
+ */
+static void closeOverflowStore (BTree *treeInfo)
+{
+	OverflowStore *store = treeInfo->overflow;
+
+	if(store == NULL)
+		return;
+
+	pinPage(store->bm,store->ph,BT_OVERFLOW_META_PAGE);
+	((int*)store->ph->data)[0] = store->numOfPages;
+	((int*)store->ph->data)[1] = store->freeHead;
+	markDirty(store->bm,store->ph);
+	unpinPage(store->bm,store->ph);
+
+	shutdownBufferPool(store->bm);
+	free(store->bm);
+	free(store->ph);
+	free(store->fileName);
+	free(store);
+	treeInfo->overflow = NULL;
+}
+
+/*
+ * Allocate an overflow page. A free page is only reused when no snapshot
+ * is open, a snapshot may still read the value that owned it
+ */
+static int allocateOverflowPage (BTree *treeInfo, OverflowStore *store)
+{
+	int page;
+
+	if(store->freeHead == NO_PAGE || treeInfo->versions->oldest != NULL)
+		return store->numOfPages++;
+
+	page = store->freeHead;
+	pinPage(store->bm,store->ph,page);
+	store->freeHead = ((int*)store->ph->data)[BT_OVERFLOW_NEXT];
+	unpinPage(store->bm,store->ph);
+	return page;
+}
+
+/*
+ * Write a value into a chain of overflow pages, returns the first page of the chain
+ */
+static int writeOverflowValue (BTree *treeInfo, OverflowStore *store, char *value, int length)
+{
+	int numOfPages = (length + BT_OVERFLOW_DATA_SIZE - 1) / BT_OVERFLOW_DATA_SIZE;
+	int *pages = (int*)malloc(sizeof(int) * numOfPages);
+	int i, first;
+
+	for(i = 0;i<numOfPages;i++)
+		pages[i] = allocateOverflowPage(treeInfo, store);
+
+	for(i = 0;i<numOfPages;i++)
+	{
+		int used = (i < numOfPages - 1) ? BT_OVERFLOW_DATA_SIZE : length - i * BT_OVERFLOW_DATA_SIZE;
+
+		pinPage(store->bm,store->ph,pages[i]);
+		((int*)store->ph->data)[BT_OVERFLOW_NEXT] = (i < numOfPages - 1) ? pages[i + 1] : NO_PAGE;
+		((int*)store->ph->data)[BT_OVERFLOW_USED] = used;
+		memcpy(store->ph->data + BT_OVERFLOW_HEADER_SIZE, value + i * BT_OVERFLOW_DATA_SIZE, used);
+		markDirty(store->bm,store->ph);
+		unpinPage(store->bm,store->ph);
+	}
+
+	first = pages[0];
+	free(pages);
+	return first;
+}
+
+/*
+ * Read the value of a chain of overflow pages into value
+ */
+static RC readOverflowValue (OverflowStore *store, int page, char *value, int length)
+{
+	int offset = 0;
+
+	while(page != NO_PAGE && offset < length)
+	{
+		int used;
+
+		if(page <= BT_OVERFLOW_META_PAGE || page >= store->numOfPages)
+		{
+			THROW(RC_READ_NON_EXISTING_PAGE, "broken overflow page chain");
+		}
+
+		pinPage(store->bm,store->ph,page);
+		used = ((int*)store->ph->data)[BT_OVERFLOW_USED];
+		if(used > length - offset)
+			used = length - offset;
+		memcpy(value + offset, store->ph->data + BT_OVERFLOW_HEADER_SIZE, used);
+		offset += used;
+		page = ((int*)store->ph->data)[BT_OVERFLOW_NEXT];
+		unpinPage(store->bm,store->ph);
+	}
+	return RC_OK;
+}
+
+/*
+ * Give the overflow pages of an entry removed from the tree back to the free list.
+ * The whole chain is pushed by linking its last page to the free list, so a
+ * snapshot still reading the value finds its pages unchanged
+ */
+static void releaseOverflowPages (BTree *treeInfo, BTree *entry)
+{
+	OverflowStore *store;
+	int page, next;
+
+	if(entry->kv == NULL || entry->kv->firstPage == NO_PAGE)
+		return;
+
+	store = getOverflowStore(treeInfo);
+	if(store == NULL)
+		return;
+
+	page = entry->kv->firstPage;
+	pinPage(store->bm,store->ph,page);
+	while((next = ((int*)store->ph->data)[BT_OVERFLOW_NEXT]) != NO_PAGE)
+	{
+		unpinPage(store->bm,store->ph);
+		page = next;
+		pinPage(store->bm,store->ph,page);
+	}
+	((int*)store->ph->data)[BT_OVERFLOW_NEXT] = store->freeHead;
+	markDirty(store->bm,store->ph);
+	unpinPage(store->bm,store->ph);
+	store->freeHead = entry->kv->firstPage;
+}
+
+/*
+ * Create the value of a key-value entry, inline or in overflow pages,
+ * returns NULL if the overflow pages cannot be opened
+ */
+static KVValue *createKVValue (BTree *treeInfo, char *value, int length)
+{
+	OverflowStore *store;
+	KVValue *kv;
+
+	if(length <= BT_KV_INLINE_MAX)
+	{
+		kv = (KVValue*)malloc(sizeof(KVValue) + length);
+		kv->length = length;
+		kv->firstPage = NO_PAGE;
+		if(length > 0)
+			memcpy(kv->data, value, length);
+		return kv;
+	}
+
+	store = getOverflowStore(treeInfo);
+	if(store == NULL)
+		return NULL;
+
+	kv = (KVValue*)malloc(sizeof(KVValue));
+	kv->length = length;
+	kv->firstPage = writeOverflowValue(treeInfo, store, value, length);
+	return kv;
+}
+
+/*
+ * Return a copy of the value of an entry, the caller frees it.
+ * An entry inserted without a value has an empty one
+ */
+static RC readKVValue (BTree *treeInfo, BTree *entry, char **value, int *length)
+{
+	KVValue *kv = entry->kv;
+	OverflowStore *store;
+
+	*value = NULL;
+	*length = 0;
+	if(kv == NULL)
+		return RC_OK;
+
+	//the copy is terminated, so a string value can be used as it is
+	*value = (char*)malloc(kv->length + 1);
+	(*value)[kv->length] = '\0';
+	*length = kv->length;
+	if(kv->firstPage == NO_PAGE)
+	{
+		memcpy(*value, kv->data, kv->length);
+		return RC_OK;
+	}
+
+	store = getOverflowStore(treeInfo);
+	if(store == NULL || readOverflowValue(store, kv->firstPage, *value, kv->length) != RC_OK)
+	{
+		free(*value);
+		*value = NULL;
+		*length = 0;
+		THROW(RC_READ_NON_EXISTING_PAGE, "cannot read the overflow pages of a value");
+	}
+	return RC_OK;
+}
+
+/*
+ * qsort comparator for the entries of a batch insert
+ */
+static int compareBatchEntries (const void *left, const void *right)
+{
+	return compareKeys(((BTreeBatchEntry*)left)->key, ((BTreeBatchEntry*)right)->key);
+}
+
+/*
+ * 64 bit FNV-1a hash of a key, used by the Bloom filter and the adaptive hash index
+ */
+static unsigned long long hashKey (Value *key)
+{
+	unsigned long long hash = 14695981039346656037ULL;
+	unsigned char *bytes;
+	int i, length;
+	float floatKey;
+	double doubleKey;
+
+	switch(key->dt)
+	{
+	case DT_STRING:
+		bytes = (unsigned char*)key->v.stringV;
+		length = strlen(key->v.stringV);
+		break;
+	case DT_FLOAT:
+		//0.0 and -0.0 compare equal, so they must hash the same
+		floatKey = (key->v.floatV == 0) ? 0 : key->v.floatV;
+		bytes = (unsigned char*)&floatKey;
+		length = sizeof(float);
+		break;
+	case DT_BOOL:
+		bytes = (unsigned char*)&key->v.boolV;
+		length = sizeof(bool);
+		break;
+	case DT_INT64:
+		bytes = (unsigned char*)&key->v.int64V;
+		length = sizeof(long long);
+		break;
+	case DT_DOUBLE:
+		doubleKey = (key->v.doubleV == 0) ? 0 : key->v.doubleV;
+		bytes = (unsigned char*)&doubleKey;
+		length = sizeof(double);
+		break;
+	default:
+		bytes = (unsigned char*)&key->v.intV;
+		length = sizeof(int);
+		break;
+	}
+
+	for(i = 0;i<length;i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+/*
+ * Allocate an empty Bloom filter for the given number of keys
+ */
+static BloomFilter *createBloomFilter (int bitsPerKey, int capacity)
+{
+	BloomFilter *bloom = (BloomFilter*)malloc(sizeof(BloomFilter));
+
+	if(capacity < BT_BLOOM_BLOCK_BITS)
+		capacity = BT_BLOOM_BLOCK_BITS;
+
+	bloom->bitsPerKey = bitsPerKey;
+	bloom->capacity = capacity;
+	bloom->numOfBlocks = (int)(((long long)capacity * bitsPerKey + BT_BLOOM_BLOCK_BITS - 1) / BT_BLOOM_BLOCK_BITS);
+
+	//k = bitsPerKey * ln(2) gives the lowest false positive rate
+	bloom->numOfHashes = (bitsPerKey * 69 + 50) / 100;
+	if(bloom->numOfHashes < 1)
+		bloom->numOfHashes = 1;
+	if(bloom->numOfHashes > 16)
+		bloom->numOfHashes = 16;
+
+	bloom->bits = (unsigned char*)calloc(bloom->numOfBlocks, BT_BLOOM_BLOCK_SIZE);
+	return bloom;
+}
+
+/*
+ * Free the Bloom filter
+ */
+static void freeBloomFilter (BloomFilter *bloom)
+{
+	if(bloom == NULL)
+		return;
+	free(bloom->bits);
+	free(bloom);
+}
+
+/*
+ * Set the bits of a key, the high half of the hash picks the block
+ * and the low half drives the double hashing inside that block
+ */
+static void bloomAdd (BloomFilter *bloom, Value *key)
+{
+	unsigned long long hash = hashKey(key);
+	unsigned char *block = bloom->bits + ((hash >> 32) % bloom->numOfBlocks) * BT_BLOOM_BLOCK_SIZE;
+	unsigned int h1 = (unsigned int)hash;
+	unsigned int h2 = (h1 >> 17) | (h1 << 15);
+	int i;
+
+	for(i = 0;i<bloom->numOfHashes;i++)
+	{
+		unsigned int bit = (h1 + i * h2) % BT_BLOOM_BLOCK_BITS;
+		block[bit / 8] |= (1 << (bit % 8));
+	}
+}
+
+/*
+ * Check the bits of a key, returns FALSE only when the key is surely absent
+ */
+static bool bloomMayContain (BloomFilter *bloom, Value *key)
+{
+	unsigned long long hash = hashKey(key);
+	unsigned char *block = bloom->bits + ((hash >> 32) % bloom->numOfBlocks) * BT_BLOOM_BLOCK_SIZE;
+	unsigned int h1 = (unsigned int)hash;
+	unsigned int h2 = (h1 >> 17) | (h1 << 15);
+	int i;
+
+	for(i = 0;i<bloom->numOfHashes;i++)
+	{
+		unsigned int bit = (h1 + i * h2) % BT_BLOOM_BLOCK_BITS;
+		if(!(block[bit / 8] & (1 << (bit % 8))))
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Rebuild the Bloom filter of the tree from all its entries,
+ * sized for twice the current number of keys so inserts do not saturate it
+ */
+static void rebuildBloomFilter (BTree *treeInfo)
+{
+	int i;
+	int bitsPerKey = treeInfo->bloom->bitsPerKey;
+
+	freeBloomFilter(treeInfo->bloom);
+	treeInfo->bloom = createBloomFilter(bitsPerKey, 2 * treeInfo->numOfKeys);
+
+	for(i = 0;i<treeInfo->numOfKeys;i++)
+	{
+		bloomAdd(treeInfo->bloom, &treeInfo->entries[i]->value);
+	}
+}
+
+/*
+ * Write the Bloom filter blocks to the pages following the leaves
+ * and record its size in the header
+ */
+static void writeBloomFilter (BTree *treeInfo)
+{
+	BloomFilter *bloom = treeInfo->bloom;
+	SM_FileHandle fh;
+	char *pages;
+	int numOfPages, firstPage = BT_LEAF_FIRST_PAGE + treeInfo->numOfLeafPages;
+
+	pinPage(treeInfo->bm,treeInfo->ph,BT_HEADER_PAGE);
+	((int*)treeInfo->ph->data)[BT_HEADER_BLOOM_BITS] = (bloom == NULL) ? 0 : bloom->bitsPerKey;
+	((int*)treeInfo->ph->data)[BT_HEADER_BLOOM_BLOCKS] = (bloom == NULL) ? 0 : bloom->numOfBlocks;
+	markDirty(treeInfo->bm,treeInfo->ph);
+	unpinPage(treeInfo->bm,treeInfo->ph);
+
+	if(bloom == NULL)
+		return;
+
+	numOfPages = (bloom->numOfBlocks + BT_BLOOM_BLOCKS_PER_PAGE - 1) / BT_BLOOM_BLOCKS_PER_PAGE;
+	pages = (char*)calloc(numOfPages, PAGE_SIZE);
+	memcpy(pages, bloom->bits, bloom->numOfBlocks * BT_BLOOM_BLOCK_SIZE);
+
+	//the filter pages bypass the buffer pool and are written as one contiguous run,
+	//the pool must not keep an older copy of them
+	if(discardPages(treeInfo->bm, firstPage, numOfPages) == RC_OK
+			&& openPageFile(treeInfo->bm->pageFile, &fh) == RC_OK)
+	{
+		ensureCapacity(firstPage + numOfPages, &fh);
+		writeBlocks(firstPage, numOfPages, &fh, pages);
+		closePageFile(&fh);
+	}
+	free(pages);
+}
+
+/*
+ * Load the Bloom filter blocks described by the header page, if the index has one
+ */
+static void readBloomFilter (BTree *treeInfo, int bitsPerKey, int numOfBlocks)
+{
+	BloomFilter *bloom;
+	SM_FileHandle fh;
+	char *pages;
+	int numOfPages, firstPage = BT_LEAF_FIRST_PAGE + treeInfo->numOfLeafPages;
+
+	if(bitsPerKey <= 0 || numOfBlocks <= 0)
+		return;
+
+	bloom = createBloomFilter(bitsPerKey, numOfBlocks * BT_BLOOM_BLOCK_BITS / bitsPerKey);
+	if(bloom->numOfBlocks != numOfBlocks)
+	{
+		free(bloom->bits);
+		bloom->numOfBlocks = numOfBlocks;
+		bloom->bits = (unsigned char*)calloc(numOfBlocks, BT_BLOOM_BLOCK_SIZE);
+	}
+
+	//read all the filter pages with a single read,
+	//without them the index works without its filter rather than with an empty one
+	numOfPages = (numOfBlocks + BT_BLOOM_BLOCKS_PER_PAGE - 1) / BT_BLOOM_BLOCKS_PER_PAGE;
+	pages = (char*)malloc(numOfPages * PAGE_SIZE);
+	if(discardPages(treeInfo->bm, firstPage, numOfPages) == RC_OK
+			&& openPageFile(treeInfo->bm->pageFile, &fh) == RC_OK)
+	{
+		if(readBlocks(firstPage, numOfPages, &fh, pages) == RC_OK)
+		{
+			memcpy(bloom->bits, pages, numOfBlocks * BT_BLOOM_BLOCK_SIZE);
+			treeInfo->bloom = bloom;
+		}
+		closePageFile(&fh);
+	}
+	free(pages);
+
+	if(treeInfo->bloom == NULL)
+		freeBloomFilter(bloom);
+}
+
+/*
+ * Allocate an empty adaptive hash index
+ */
+static AdaptiveHashIndex *createAdaptiveHashIndex (void)
+{
+	AdaptiveHashIndex *ahi = (AdaptiveHashIndex*)calloc(1, sizeof(AdaptiveHashIndex) + sizeof(AdaptiveHashSlot) * (BT_AHI_SLOTS - 1));
+
+	//generation 0 is never current, so empty slots are never used
+	ahi->generation = 1;
+	return ahi;
+}
+
+/*
+ * Forget every position recorded in the adaptive hash index,
+ * the hit counters are kept so hot keys are hashed again on their next lookup
+ */
+static void invalidateAdaptiveHashIndex (BTree *treeInfo)
+{
+	if(treeInfo->ahi != NULL)
+		treeInfo->ahi->generation++;
+}
+
+/*
+ * Look a key up in the adaptive hash index,
+ * returns its position or -1 when the key is not hashed (yet)
+ */
+static int adaptiveHashLookup (BTree *treeInfo, Value *key, unsigned long long hash)
+{
+	AdaptiveHashIndex *ahi = treeInfo->ahi;
+	AdaptiveHashSlot *slot = &ahi->slots[hash % BT_AHI_SLOTS];
+
+	if(slot->hash != hash || slot->generation != ahi->generation || slot->position >= treeInfo->numOfKeys)
+		return -1;
+
+	//different keys may share a hash, the entry itself decides
+	if(compareKeys(&treeInfo->entries[slot->position]->value, key) != 0)
+		return -1;
+
+	slot->hits++;
+	return slot->position;
+}
+
+/*
+ * Count a lookup that had to search the entries,
+ * once the key was looked up often enough its position is recorded
+ */
+static void adaptiveHashRecord (AdaptiveHashIndex *ahi, unsigned long long hash, int position)
+{
+	AdaptiveHashSlot *slot = &ahi->slots[hash % BT_AHI_SLOTS];
+
+	if(slot->hash != hash)
+	{
+		slot->hash = hash;
+		slot->hits = 0;
+		slot->generation = 0;
+	}
+
+	slot->hits++;
+	if(slot->hits >= BT_AHI_THRESHOLD)
+	{
+		slot->position = position;
+		slot->generation = ahi->generation;
+	}
+}
+
+/*
+ * Fit the segments of the learned index over the current entries.
+ * Each segment grows while a single slope keeps every key within maxError
+ * of its position: the cone of such slopes narrows with every key and the
+ * segment ends at the first key outside of it
+ */
+static void buildLearnedIndex (BTree *treeInfo)
+{
+	LearnedIndex *learned = treeInfo->learned;
+	BTree **entries = treeInfo->entries;
+	int i = 0, start;
+	double firstKey, dx, slope, slopeLow, slopeHigh;
+	LearnedSegment *segment;
+
+	learned->segments = (LearnedSegment*)realloc(learned->segments, sizeof(LearnedSegment) * (treeInfo->numOfKeys + 1));
+	learned->numOfSegments = 0;
+
+	while(i < treeInfo->numOfKeys)
+	{
+		start = i;
+		firstKey = entries[i]->value.v.intV;
+		slopeLow = 0;
+		slopeHigh = DBL_MAX;
+
+		for(i++;i<treeInfo->numOfKeys;i++)
+		{
+			dx = entries[i]->value.v.intV - firstKey;
+			slope = (i - start) / dx;
+			if(slope < slopeLow || slope > slopeHigh)
+				break;
+
+			if((i - start - learned->maxError) / dx > slopeLow)
+				slopeLow = (i - start - learned->maxError) / dx;
+			if((i - start + learned->maxError) / dx < slopeHigh)
+				slopeHigh = (i - start + learned->maxError) / dx;
+		}
+
+		segment = &learned->segments[learned->numOfSegments++];
+		segment->firstKey = (int)firstKey;
+		segment->position = start;
+		segment->slope = (i - start == 1) ? 0 : (slopeLow + slopeHigh) / 2;
+	}
+
+	//the segments are usually far fewer than the keys
+	learned->segments = (LearnedSegment*)realloc(learned->segments, sizeof(LearnedSegment) * (learned->numOfSegments + 1));
+	learned->valid = TRUE;
+	learned->staleLookups = 0;
+}
+
+/*
+ * Search the entries through the learned index, same result as searchKeyPosition:
+ * the segment of the key is found with a binary search over the segments and
+ * the key with a binary search of the 2 * maxError entries around the predicted position
+ */
+static int learnedSearchPosition (BTree *treeInfo, Value *key, int *found)
+{
+	LearnedIndex *learned = treeInfo->learned;
+	BTree **entries = treeInfo->entries;
+	int k = key->v.intV;
+	int low = 0, high = learned->numOfSegments - 1, seg = -1;
+	int segStart, segEnd, pos, mid;
+	double predicted;
+
+	//last segment starting at or before the key
+	while(low <= high)
+	{
+		mid = low + (high - low) / 2;
+		if(learned->segments[mid].firstKey <= k)
+		{
+			seg = mid;
+			low = mid + 1;
+		}
+		else
+			high = mid - 1;
+	}
+
+	if(seg < 0)	//smaller than every key
+	{
+		*found = 0;
+		return 0;
+	}
+
+	segStart = learned->segments[seg].position;
+	segEnd = (seg + 1 < learned->numOfSegments) ? learned->segments[seg + 1].position : treeInfo->numOfKeys;
+	predicted = segStart + learned->segments[seg].slope * ((double)k - learned->segments[seg].firstKey);
+	if(predicted > segEnd)
+		predicted = segEnd;
+
+	low = (int)predicted - learned->maxError - 1;
+	high = (int)predicted + learned->maxError + 2;
+	if(low < segStart)
+		low = segStart;
+	if(high > segEnd)
+		high = segEnd;
+
+	while(low < high)
+	{
+		mid = low + (high - low) / 2;
+		if(entries[mid]->value.v.intV < k)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	pos = low;
+
+	//the bound holds for every stored key, fall back to a full search if it ever did not
+	if((pos > 0 && entries[pos - 1]->value.v.intV >= k) || (pos < treeInfo->numOfKeys && entries[pos]->value.v.intV < k))
+		return searchKeyPosition(treeInfo, key, found);
+
+	*found = (pos < treeInfo->numOfKeys && entries[pos]->value.v.intV == k);
+	return pos;
+}
+
+/*
+ * Check whether the DT_INT keys are close enough to uniform for interpolation search:
+ * the keys at evenly spaced positions must be near the positions a line through
+ * the smallest and the largest key predicts for them
+ */
+static bool sampleUniformKeys (BTree *treeInfo)
+{
+	double minKey, range, predicted, error;
+	int i, pos, maxError = treeInfo->numOfKeys / BT_INTERPOLATION_SKEW;
+
+	if(treeInfo->numOfKeys < 2)
+		return FALSE;
+
+	minKey = treeInfo->entries[0]->value.v.intV;
+	range = (double)treeInfo->entries[treeInfo->numOfKeys - 1]->value.v.intV - minKey;
+	if(range <= 0)
+		return FALSE;
+
+	for(i = 0;i<BT_INTERPOLATION_SAMPLES;i++)
+	{
+		pos = (int)((long long)i * (treeInfo->numOfKeys - 1) / (BT_INTERPOLATION_SAMPLES - 1));
+		predicted = (treeInfo->entries[pos]->value.v.intV - minKey) / range * (treeInfo->numOfKeys - 1);
+		error = predicted - pos;
+		if(error > maxError || -error > maxError)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/*
+ * Interpolation search over DT_INT keys, returns what searchKeyPosition returns.
+ * Every probe is placed where the key would be if the keys between the bounds were uniform;
+ * after BT_INTERPOLATION_STEPS probes the rest of the range is searched binary,
+ * so skewed keys cost at most those few extra probes
+ */
+static int interpolationSearchPosition (BTree *treeInfo, Value *key, int *found)
+{
+	BTree **entries = treeInfo->entries;
+	int low = 0, high = treeInfo->numOfKeys;
+	int target = key->v.intV;
+	int steps, probe, lowKey, highKey;
+
+	//the position of the first key >= target stays in [low, high]
+	for(steps = 0;steps < BT_INTERPOLATION_STEPS && low < high;steps++)
+	{
+		lowKey = entries[low]->value.v.intV;
+		highKey = entries[high - 1]->value.v.intV;
+		if(target <= lowKey)
+		{
+			high = low;
+			break;
+		}
+		if(target > highKey)
+		{
+			low = high;
+			break;
+		}
+
+		probe = low + (int)((double)((long long)target - lowKey) / ((long long)highKey - lowKey) * (high - 1 - low));
+		if(entries[probe]->value.v.intV < target)
+			low = probe + 1;
+		else
+			high = probe;
+	}
+
+	BT_SEARCH_FIXED(entries, intV, target, low, high);
+
+	*found = (low < treeInfo->numOfKeys && entries[low]->value.v.intV == target);
+	return low;
+}
+
+/*
+ * Copy the keys into the slots of the subtree rooted at slot k in key order,
+ * i is the position of the next key, returns the position after the subtree
+ */
+static int fillEytzingerSlots (EytzingerLayout *layout, BTree **entries, int i, int k)
+{
+	if(k > layout->numOfSlots)
+		return i;
+
+	i = fillEytzingerSlots(layout, entries, i, 2 * k);
+	layout->slots[k] = entries[i]->value;
+	layout->positions[k] = i++;
+	return fillEytzingerSlots(layout, entries, i, 2 * k + 1);
+}
+
+static void buildEytzingerLayout (BTree *treeInfo)
+{
+	EytzingerLayout *layout = treeInfo->eytzinger;
+
+	free(layout->slots);
+	free(layout->positions);
+	layout->numOfSlots = treeInfo->numOfKeys;
+	layout->slots = (Value*)malloc(sizeof(Value) * (treeInfo->numOfKeys + 1));
+	layout->positions = (int*)malloc(sizeof(int) * (treeInfo->numOfKeys + 1));
+	fillEytzingerSlots(layout, treeInfo->entries, 0, 1);
+	layout->valid = TRUE;
+	layout->staleLookups = 0;
+}
+
+static void freeEytzingerLayout (BTree *treeInfo)
+{
+	if(treeInfo->eytzinger == NULL)
+		return;
+	free(treeInfo->eytzinger->slots);
+	free(treeInfo->eytzinger->positions);
+	free(treeInfo->eytzinger);
+	treeInfo->eytzinger = NULL;
+}
+
+//Walk of an Eytzinger search over a fixed-width key: the comparison only picks
+//the child, so the loop has no branch that depends on the keys
+#define BT_EYTZINGER_FIXED(slots, numOfSlots, field, target, k)			\
+	while(k <= numOfSlots)												\
+	{																	\
+		BT_PREFETCH(&slots[BT_EYTZINGER_PREFETCH_SLOT(k, numOfSlots)]);	\
+		k = 2 * k + (slots[k].v.field < (target));						\
+	}
+
+/*
+ * Search the Eytzinger layout, returns what searchKeyPosition returns
+ */
+static int eytzingerSearchPosition (EytzingerLayout *layout, Value *key, int *found)
+{
+	Value *slots = layout->slots;
+	int numOfSlots = layout->numOfSlots;
+	int k = 1;
+
+	switch(key->dt)
+	{
+	case DT_INT:
+		BT_EYTZINGER_FIXED(slots, numOfSlots, intV, key->v.intV, k);
+		break;
+	case DT_INT64:
+		BT_EYTZINGER_FIXED(slots, numOfSlots, int64V, key->v.int64V, k);
+		break;
+	case DT_FLOAT:
+		BT_EYTZINGER_FIXED(slots, numOfSlots, floatV, key->v.floatV, k);
+		break;
+	case DT_DOUBLE:
+		BT_EYTZINGER_FIXED(slots, numOfSlots, doubleV, key->v.doubleV, k);
+		break;
+	default:
+		while(k <= numOfSlots)
+		{
+			BT_PREFETCH(&slots[BT_EYTZINGER_PREFETCH_SLOT(k, numOfSlots)]);
+			k = 2 * k + (compareKeys(&slots[k], key) < 0);
+		}
+		break;
+	}
+
+	//the walk went right after the last slot whose key is >= key,
+	//dropping those right turns and the left turn before them leads back to it
+	while(k & 1)
+		k >>= 1;
+	k >>= 1;
+
+	if(k == 0)
+	{
+		*found = FALSE;
+		return numOfSlots;
+	}
+	*found = (compareKeys(&slots[k], key) == 0);
+	return layout->positions[k];
+}
+
+/*
+ * Find the position of a key like searchKeyPosition, through the Eytzinger layout,
+ * the learned index or interpolation search when the tree uses one
+ */
+static int locateKey (BTree *treeInfo, Value *key, int *found)
+{
+	LearnedIndex *learned = treeInfo->learned;
+	InterpolationSearch *interpolation = treeInfo->interpolation;
+	EytzingerLayout *eytzinger = treeInfo->eytzinger;
+
+	//the read-only layout is rebuilt after a write once enough lookups paid for it
+	if(eytzinger != NULL)
+	{
+		if(!eytzinger->valid && ++eytzinger->staleLookups > treeInfo->numOfKeys / BT_LEARNED_REBUILD_DIVISOR)
+			buildEytzingerLayout(treeInfo);
+		if(eytzinger->valid)
+			return eytzingerSearchPosition(eytzinger, key, found);
+	}
+
+	if(learned == NULL && interpolation != NULL)
+	{
+		//a new sample after a write waits for a few lookups, until then the last verdict holds
+		if(!interpolation->valid && ++interpolation->staleLookups > BT_INTERPOLATION_RESAMPLE)
+		{
+			interpolation->uniform = sampleUniformKeys(treeInfo);
+			interpolation->valid = TRUE;
+			interpolation->staleLookups = 0;
+		}
+		if(interpolation->uniform)
+			return interpolationSearchPosition(treeInfo, key, found);
+	}
+
+	if(learned == NULL)
+		return searchKeyPosition(treeInfo, key, found);
+
+	//rebuilding a stale model costs a pass over the entries, so it waits for enough lookups
+	if(!learned->valid)
+	{
+		learned->staleLookups++;
+		if(learned->staleLookups <= treeInfo->numOfKeys / BT_LEARNED_REBUILD_DIVISOR)
+			return searchKeyPosition(treeInfo, key, found);
+		buildLearnedIndex(treeInfo);
+	}
+	return learnedSearchPosition(treeInfo, key, found);
+}
+
+static void freeLearnedIndex (BTree *treeInfo)
+{
+	if(treeInfo->learned == NULL)
+		return;
+	free(treeInfo->learned->segments);
+	free(treeInfo->learned);
+	treeInfo->learned = NULL;
+}
+
+/*
+ * Forget everything derived from the positions of the entries,
+ * called whenever an insert or delete moves entries
+ */
+static void entriesChanged (BTree *treeInfo)
+{
+	invalidateAdaptiveHashIndex(treeInfo);
+	if(treeInfo->learned != NULL)
+		treeInfo->learned->valid = FALSE;
+	if(treeInfo->interpolation != NULL)
+		treeInfo->interpolation->valid = FALSE;
+	if(treeInfo->eytzinger != NULL)
+		treeInfo->eytzinger->valid = FALSE;
+}
+
+static void freeHistogramBounds (KeyHistogram *histogram)
+{
+	int b;
+
+	for(b = 0;histogram->bounds != NULL && b<=histogram->numOfBuckets;b++)
+	{
+		if(histogram->bounds[b].dt == DT_STRING)
+			free(histogram->bounds[b].v.stringV);
+	}
+	free(histogram->bounds);
+	free(histogram->counts);
+	histogram->bounds = NULL;
+	histogram->counts = NULL;
+	histogram->numOfBuckets = 0;
+}
+
+/*
+ * Take the bounds of the histogram from the entries: the buckets are runs of whole
+ * leaves of N keys, so only the first key of every run and the largest key are read
+ */
+static void buildKeyHistogram (BTree *treeInfo)
+{
+	KeyHistogram *histogram = treeInfo->histogram;
+	int n = treeInfo->maxNumOfKeysPerNode;
+	int numOfLeaves = (treeInfo->numOfKeys + n - 1) / n;
+	int b, start, end;
+
+	freeHistogramBounds(histogram);
+	histogram->numOfBuckets = (numOfLeaves < BT_HISTOGRAM_BUCKETS) ? numOfLeaves : BT_HISTOGRAM_BUCKETS;
+	histogram->numOfKeys = treeInfo->numOfKeys;
+	histogram->changes = 0;
+	if(histogram->numOfBuckets == 0)
+		return;
+
+	histogram->bounds = (Value*)malloc(sizeof(Value) * (histogram->numOfBuckets + 1));
+	histogram->counts = (int*)malloc(sizeof(int) * histogram->numOfBuckets);
+	for(b = 0;b<histogram->numOfBuckets;b++)
+	{
+		start = (int)((long long)b * numOfLeaves / histogram->numOfBuckets) * n;
+		end = (int)((long long)(b + 1) * numOfLeaves / histogram->numOfBuckets) * n;
+		if(end > treeInfo->numOfKeys)
+			end = treeInfo->numOfKeys;
+		copyValue(&histogram->bounds[b], &treeInfo->entries[start]->value);
+		histogram->counts[b] = end - start;
+	}
+	copyValue(&histogram->bounds[histogram->numOfBuckets], &treeInfo->entries[treeInfo->numOfKeys - 1]->value);
+}
+
+static void freeKeyHistogram (BTree *treeInfo)
+{
+	if(treeInfo->histogram == NULL)
+		return;
+	freeHistogramBounds(treeInfo->histogram);
+	free(treeInfo->histogram);
+	treeInfo->histogram = NULL;
+}
+
+/*
+ * Bucket of a key, the last bucket whose lower bound is <= key (bucket 0 for smaller keys)
+ */
+static int findHistogramBucket (KeyHistogram *histogram, Value *key)
+{
+	int low = 0, high = histogram->numOfBuckets - 1;
+
+	while(low < high)
+	{
+		int mid = low + (high - low + 1) / 2;
+
+		if(compareKeys(&histogram->bounds[mid], key) <= 0)
+			low = mid;
+		else
+			high = mid - 1;
+	}
+	return low;
+}
+
+/*
+ * Take the bounds again once the counts drifted too far from them.
+ * Pending messages are counted but not in the entries yet, so that waits for the merge
+ */
+static void refreshKeyHistogram (BTree *treeInfo)
+{
+	KeyHistogram *histogram = treeInfo->histogram;
+
+	if(histogram == NULL || histogram->changes <= histogram->numOfKeys / BT_HISTOGRAM_REBUILD_DIVISOR)
+		return;
+	if(treeInfo->buffer != NULL && treeInfo->buffer->count > 0)
+		return;
+	buildKeyHistogram(treeInfo);
+}
+
+/*
+ * Count an inserted (delta 1) or deleted (delta -1) key in its bucket,
+ * a key beyond the smallest or largest key becomes the new outer bound
+ */
+static void updateKeyHistogram (BTree *treeInfo, Value *key, int delta)
+{
+	KeyHistogram *histogram = treeInfo->histogram;
+	int last, b;
+
+	if(histogram == NULL)
+		return;
+
+	last = histogram->numOfBuckets;
+	if(last > 0)
+	{
+		if(delta > 0 && compareKeys(key, &histogram->bounds[0]) < 0)
+		{
+			if(histogram->bounds[0].dt == DT_STRING)
+				free(histogram->bounds[0].v.stringV);
+			copyValue(&histogram->bounds[0], key);
+		}
+		else if(delta > 0 && compareKeys(key, &histogram->bounds[last]) > 0)
+		{
+			if(histogram->bounds[last].dt == DT_STRING)
+				free(histogram->bounds[last].v.stringV);
+			copyValue(&histogram->bounds[last], key);
+		}
+
+		b = findHistogramBucket(histogram, key);
+		histogram->counts[b] += delta;
+		if(histogram->counts[b] < 0)
+			histogram->counts[b] = 0;
+		histogram->numOfKeys += delta;
+		if(histogram->numOfKeys < 0)
+			histogram->numOfKeys = 0;
+	}
+	histogram->changes++;
+	refreshKeyHistogram(treeInfo);
+}
+
+/*
+ * Share of the keys of the bucket from low to high that are below key (or up to key
+ * when inclusive), assuming they are spread evenly. Keys that are not numbers give half
+ */
+static double bucketShare (Value *low, Value *high, Value *key, bool inclusive)
+{
+	double offset, span, share;
+
+	switch(key->dt)
+	{
+	case DT_INT:
+		offset = (double)key->v.intV - low->v.intV + (inclusive ? 1 : 0);
+		span = (double)high->v.intV - low->v.intV;
+		break;
+	case DT_INT64:
+		offset = (double)key->v.int64V - (double)low->v.int64V + (inclusive ? 1 : 0);
+		span = (double)high->v.int64V - (double)low->v.int64V;
+		break;
+	case DT_FLOAT:
+		offset = (double)key->v.floatV - low->v.floatV;
+		span = (double)high->v.floatV - low->v.floatV;
+		break;
+	case DT_DOUBLE:
+		offset = key->v.doubleV - low->v.doubleV;
+		span = high->v.doubleV - low->v.doubleV;
+		break;
+	default:
+		return 0.5;
+	}
+
+	if(span <= 0)
+		return 1;
+	share = offset / span;
+	return (share < 0) ? 0 : (share > 1) ? 1 : share;
+}
+
+/*
+ * Estimated number of keys below key, or up to key when inclusive
+ */
+static double histogramKeysBelow (KeyHistogram *histogram, Value *key, bool inclusive)
+{
+	int last = histogram->numOfBuckets;
+	int b, i, cmp;
+	double below = 0;
+
+	if(compareKeys(key, &histogram->bounds[0]) < 0)
+		return 0;
+	cmp = compareKeys(key, &histogram->bounds[last]);
+	if(cmp > 0 || (cmp == 0 && inclusive))
+		return histogram->numOfKeys;
+
+	b = findHistogramBucket(histogram, key);
+	for(i = 0;i<b;i++)
+		below += histogram->counts[i];
+	return below + histogram->counts[b] * bucketShare(&histogram->bounds[b], &histogram->bounds[b + 1], key, inclusive);
+}
+
+/*
+ * Binary search over the sorted write buffer,
+ * returns the position of the first message whose key is >= key
+ * and sets found when that message is for exactly the key
+ */
+static int searchMessagePosition (MessageBuffer *buffer, Value *key, int *found)
+{
+	int low = 0, high = buffer->count;
+
+	while(low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if(compareKeys(&buffer->messages[mid].entry->value, key) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	*found = (low < buffer->count && compareKeys(&buffer->messages[low].entry->value, key) == 0);
+	return low;
+}
+
+/*
+ * Find the pending message for a key,
+ * returns its index in the write buffer or -1 when the key has no pending message
+ */
+static int findPendingMessage (MessageBuffer *buffer, Value *key)
+{
+	int found, pos;
+
+	if(buffer == NULL)
+		return -1;
+
+	pos = searchMessagePosition(buffer, key, &found);
+	return found ? pos : -1;
+}
+
+/*
+ * Apply all the buffered messages to the entries,
+ * the buffer is already in key order, so it is merged with the entries
+ * in a single sequential pass
+ */
+static void flushMessageBuffer (BTree *treeInfo)
+{
+	MessageBuffer *buffer = treeInfo->buffer;
+	int i, j, k;
+	int count;
+
+	if(buffer == NULL || buffer->count == 0)
+		return;
+
+	count = buffer->count;
+
+	int mergedSize = (treeInfo->allocatedKeys > treeInfo->numOfKeys + count) ? treeInfo->allocatedKeys : treeInfo->numOfKeys + count;
+	BTree **merged = (BTree**)malloc(sizeof(BTree*) * mergedSize);
+
+	i = 0; j = 0; k = 0;
+	while(j < count)
+	{
+		BTreeMessage *message = &buffer->messages[j];
+
+		//copy the existing entries smaller than the key of the message
+		while(i < treeInfo->numOfKeys && compareKeys(&treeInfo->entries[i]->value, &message->entry->value) < 0)
+			merged[k++] = treeInfo->entries[i++];
+
+		//the entries in front of the first message keep their leaves
+		if(j == 0)
+			markEntriesDirty(treeInfo, k);
+
+		//the existing entry of the key is replaced or deleted
+		if(i < treeInfo->numOfKeys && compareKeys(&treeInfo->entries[i]->value, &message->entry->value) == 0)
+		{
+			releaseOverflowPages(treeInfo, treeInfo->entries[i]);
+			retireEntry(treeInfo, treeInfo->entries[i++]);
+		}
+
+		if(message->type == BT_MSG_INSERT)
+			merged[k++] = message->entry;
+		else
+			freeEntry(message->entry);
+		j++;
+	}
+	while(i < treeInfo->numOfKeys)
+		merged[k++] = treeInfo->entries[i++];
+
+	replaceEntries(treeInfo, merged, k, mergedSize);
+	buffer->count = 0;
+	entriesChanged(treeInfo);
+
+	//the messages are already counted in the histogram, its bounds may be due now
+	refreshKeyHistogram(treeInfo);
+
+	//the buffered inserts are already in the Bloom filter, it only has to grow
+	if(treeInfo->bloom != NULL && treeInfo->numOfKeys > treeInfo->bloom->capacity)
+		rebuildBloomFilter(treeInfo);
+
+	writeHeaderEntries(treeInfo);
+}
+
+/*
+ * Add a message to the write buffer at its key position,
+ * a newer message for a key replaces the pending one.
+ * The buffer is merged into the entries first when it is full
+ */
+static void bufferMessage (BTree *treeInfo, int type, BTree *entry)
+{
+	MessageBuffer *buffer = treeInfo->buffer;
+	int found;
+	int pos = searchMessagePosition(buffer, &entry->value, &found);
+
+	if(found)
+	{
+		releaseOverflowPages(treeInfo, buffer->messages[pos].entry);
+		freeEntry(buffer->messages[pos].entry);
+		buffer->messages[pos].type = type;
+		buffer->messages[pos].entry = entry;
+		return;
+	}
+
+	if(buffer->count == buffer->capacity)
+	{
+		flushMessageBuffer(treeInfo);
+		pos = 0;
+	}
+
+	memmove(&buffer->messages[pos + 1], &buffer->messages[pos], sizeof(BTreeMessage) * (buffer->count - pos));
+	buffer->messages[pos].type = type;
+	buffer->messages[pos].entry = entry;
+	buffer->count++;
+}
+
+/*
+ * Apply and free the write buffer of the tree
+ */
+static void freeMessageBuffer (BTree *treeInfo)
+{
+	if(treeInfo->buffer == NULL)
+		return;
+
+	flushMessageBuffer(treeInfo);
+	free(treeInfo->buffer->messages);
+	free(treeInfo->buffer);
+	treeInfo->buffer = NULL;
+}
+
+/*
+ * Encode a key into bytes that compare with memcmp in key order,
+ * the ART engine indexes these bytes. The caller frees the result
+ */
+static unsigned char *encodeKey (Value *key, int *length)
+{
+	unsigned char *bytes;
+	unsigned long long bits;
+	unsigned int floatBits;
+	float floatKey;
+	double doubleKey;
+	int i, width = 4;
+
+	switch(key->dt)
+	{
+	case DT_STRING:
+		//the terminating 0 keeps a string from being a prefix of a longer one
+		*length = strlen(key->v.stringV) + 1;
+		bytes = (unsigned char*)malloc(*length);
+		memcpy(bytes, key->v.stringV, *length);
+		return bytes;
+	case DT_BOOL:
+		*length = 1;
+		bytes = (unsigned char*)malloc(1);
+		bytes[0] = key->v.boolV ? 1 : 0;
+		return bytes;
+	case DT_FLOAT:
+		//0.0 and -0.0 compare equal, negative floats sort in reverse bit order
+		floatKey = (key->v.floatV == 0) ? 0 : key->v.floatV;
+		memcpy(&floatBits, &floatKey, sizeof(floatBits));
+		bits = (floatBits & 0x80000000u) ? ~floatBits : floatBits ^ 0x80000000u;
+		break;
+	case DT_INT64:
+		bits = (unsigned long long)key->v.int64V ^ 0x8000000000000000ull;
+		width = 8;
+		break;
+	case DT_DOUBLE:
+		doubleKey = (key->v.doubleV == 0) ? 0 : key->v.doubleV;
+		memcpy(&bits, &doubleKey, sizeof(bits));
+		bits = (bits & 0x8000000000000000ull) ? ~bits : bits ^ 0x8000000000000000ull;
+		width = 8;
+		break;
+	default:
+		//flipping the sign bit orders negative ints before positive ones
+		bits = (unsigned int)key->v.intV ^ 0x80000000u;
+		break;
+	}
+
+	//big endian, the most significant byte is compared first
+	*length = width;
+	bytes = (unsigned char*)malloc(width);
+	for(i = 0;i<width;i++)
+		bytes[i] = (bits >> (8 * (width - 1 - i))) & 0xff;
+	return bytes;
+}
+
+/*
+ * 32 bit hash of a key for the extendible hash engine, its low bits pick the bucket
+ */
+static unsigned int hashKeyBits (Value *key)
+{
+	unsigned long long hash = hashKey(key);
+
+	return (unsigned int)(hash ^ (hash >> 32));
+}
+
+/*
+ * findKey of the extendible hash engine
+ */
+static RC findKeyHash (BTree *treeInfo, Value *key, RID *result)
+{
+	int length;
+	unsigned char *bytes = encodeKey(key, &length);
+	RC rc = hashFind(treeInfo->hash, hashKeyBits(key), bytes, length, result);
+
+	free(bytes);
+	return rc;
+}
+
+/*
+ * insertKey of the extendible hash engine, the bucket only keeps the key and its RID
+ */
+static RC insertKeyHash (BTree *treeInfo, Value *key, RID rid)
+{
+	int length;
+	unsigned char *bytes = encodeKey(key, &length);
+	RC rc = hashInsert(treeInfo->hash, hashKeyBits(key), bytes, length, rid);
+
+	free(bytes);
+	return rc;
+}
+
+/*
+ * deleteKey of the extendible hash engine
+ */
+static RC deleteKeyHash (BTree *treeInfo, Value *key)
+{
+	int length;
+	unsigned char *bytes = encodeKey(key, &length);
+	RC rc = hashDelete(treeInfo->hash, hashKeyBits(key), bytes, length);
+
+	free(bytes);
+	return rc;
+}
+
+/*
+ * findKey of a frozen export, a binary search over the mapped slots
+ */
+static RC findKeyFrozen (BTree *treeInfo, Value *key, RID *result)
+{
+	Value slotKey;
+	int found;
+	int pos = frozenSearch(treeInfo->frozen, key, &found);
+
+	if(!found)
+	{
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	frozenEntry(treeInfo->frozen, pos, &slotKey, result);
+	return RC_OK;
+}
+
+/*
+ * Free an entry stored in the ART engine, used as the callback of artFree
+ */
+static void freeArtEntry (void *entry)
+{
+	freeEntry((BTree*)entry);
+}
+
+/*
+ * Free the keys of the ART engine
+ */
+static void freeArtIndex (BTree *treeInfo)
+{
+	artFree(treeInfo->art, freeArtEntry);
+	treeInfo->art = NULL;
+}
+
+/*
+ * findKey of the ART engine
+ */
+static RC findKeyART (BTree *treeInfo, Value *key, RID *result)
+{
+	int length;
+	unsigned char *bytes = encodeKey(key, &length);
+	BTree *entry = (BTree*)artSearch(treeInfo->art, bytes, length);
+
+	free(bytes);
+	if(entry == NULL)
+	{
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	result->page = entry->rid.page;
+	result->slot = entry->rid.slot;
+	return RC_OK;
+}
+
+/*
+ * insertKey of the ART engine, the leaf keeps the entry with its RID and payload
+ */
+static RC insertKeyART (BTree *treeInfo, Value *key, RID rid, Value **payload)
+{
+	int length;
+	unsigned char *bytes = encodeKey(key, &length);
+	BTree *entry = createEntry(key, rid, payload, treeInfo->numOfIncluded);
+	int inserted = artInsert(treeInfo->art, bytes, length, entry);
+
+	free(bytes);
+	if(!inserted)	//key already exists
+	{
+		freeEntry(entry);
+		return RC_IM_KEY_ALREADY_EXISTS;
+	}
+
+	//the radix tree has no positions, its leaves are all written again
+	markEntriesDirty(treeInfo, 0);
+	return RC_OK;
+}
+
+/*
+ * deleteKey of the ART engine
+ */
+static RC deleteKeyART (BTree *treeInfo, Value *key)
+{
+	int length;
+	unsigned char *bytes = encodeKey(key, &length);
+	BTree *entry = (BTree*)artDelete(treeInfo->art, bytes, length);
+
+	free(bytes);
+	if(entry == NULL)
+	{
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	freeEntry(entry);
+	markEntriesDirty(treeInfo, 0);
+	return RC_OK;
+}
+
+/*
+ * Copy length bytes into a leaf page and move past them
+ */
+static void putLeafBytes (char **dest, void *src, int length)
+{
+	memcpy(*dest, src, length);
+	*dest += length;
+}
+
+/*
+ * Copy length bytes out of a leaf page and move past them
+ */
+static void getLeafBytes (char **src, void *dest, int length)
+{
+	memcpy(dest, *src, length);
+	*src += length;
+}
+
+/*
+ * Bytes of a value in a leaf page: its datatype followed by the value,
+ * a string is stored with its length and without the terminating 0
+ */
+static int leafValueBytes (Value *value)
+{
+	switch(value->dt)
+	{
+	case DT_STRING:
+		return 2 * sizeof(int) + strlen(value->v.stringV);
+	case DT_INT64:
+		return sizeof(int) + sizeof(long long);
+	case DT_DOUBLE:
+		return sizeof(int) + sizeof(double);
+	default:
+		return 2 * sizeof(int);
+	}
+}
+
+/*
+ * Bytes of an entry in a leaf page: the key, the RID, the included values
+ * and the length of its value (-1 for an index entry) followed by the first
+ * overflow page and the bytes of an inline value
+ */
+static int leafEntryBytes (BTree *entry)
+{
+	int i, bytes = leafValueBytes(&entry->value) + 4 * sizeof(int);
+
+	for(i = 0;i<entry->numOfIncluded;i++)
+		bytes += leafValueBytes(entry->payload[i]);
+	if(entry->kv != NULL)
+	{
+		bytes += sizeof(int);
+		if(entry->kv->firstPage == NO_PAGE)
+			bytes += entry->kv->length;
+	}
+	return bytes;
+}
+
+static void writeLeafValue (char **dest, Value *value)
+{
+	int dt = value->dt, length, boolV;
+
+	putLeafBytes(dest, &dt, sizeof(int));
+	switch(value->dt)
+	{
+	case DT_STRING:
+		length = strlen(value->v.stringV);
+		putLeafBytes(dest, &length, sizeof(int));
+		putLeafBytes(dest, value->v.stringV, length);
+		break;
+	case DT_FLOAT:
+		putLeafBytes(dest, &value->v.floatV, sizeof(int));
+		break;
+	case DT_BOOL:
+		boolV = value->v.boolV;
+		putLeafBytes(dest, &boolV, sizeof(int));
+		break;
+	case DT_INT64:
+		putLeafBytes(dest, &value->v.int64V, sizeof(long long));
+		break;
+	case DT_DOUBLE:
+		putLeafBytes(dest, &value->v.doubleV, sizeof(double));
+		break;
+	default:
+		putLeafBytes(dest, &value->v.intV, sizeof(int));
+		break;
+	}
+}
+
+static void readLeafValue (char **src, Value *value)
+{
+	int dt, length, boolV;
+
+	getLeafBytes(src, &dt, sizeof(int));
+	value->dt = dt;
+	switch(value->dt)
+	{
+	case DT_STRING:
+		getLeafBytes(src, &length, sizeof(int));
+		value->v.stringV = (char*)malloc(length + 1);
+		getLeafBytes(src, value->v.stringV, length);
+		value->v.stringV[length] = '\0';
+		break;
+	case DT_FLOAT:
+		getLeafBytes(src, &value->v.floatV, sizeof(int));
+		break;
+	case DT_BOOL:
+		getLeafBytes(src, &boolV, sizeof(int));
+		value->v.boolV = boolV;
+		break;
+	case DT_INT64:
+		getLeafBytes(src, &value->v.int64V, sizeof(long long));
+		break;
+	case DT_DOUBLE:
+		getLeafBytes(src, &value->v.doubleV, sizeof(double));
+		break;
+	default:
+		getLeafBytes(src, &value->v.intV, sizeof(int));
+		break;
+	}
+}
+
+static void writeLeafEntry (char **dest, BTree *entry)
+{
+	int i, length = (entry->kv == NULL) ? -1 : entry->kv->length;
+
+	writeLeafValue(dest, &entry->value);
+	putLeafBytes(dest, &entry->rid.page, sizeof(int));
+	putLeafBytes(dest, &entry->rid.slot, sizeof(int));
+	putLeafBytes(dest, &entry->numOfIncluded, sizeof(int));
+	for(i = 0;i<entry->numOfIncluded;i++)
+		writeLeafValue(dest, entry->payload[i]);
+
+	putLeafBytes(dest, &length, sizeof(int));
+	if(entry->kv != NULL)
+	{
+		putLeafBytes(dest, &entry->kv->firstPage, sizeof(int));
+		if(entry->kv->firstPage == NO_PAGE)
+			putLeafBytes(dest, entry->kv->data, entry->kv->length);
+	}
+}
+
+/*
+ * Allocate an entry read from a leaf page, it is freed like any other entry
+ */
+static BTree *readLeafEntry (char **src)
+{
+	BTree *entry = (BTree*)malloc(sizeof(BTree));
+	int i, length, firstPage;
+
+	entry->block = NULL;
+	readLeafValue(src, &entry->value);
+	getLeafBytes(src, &entry->rid.page, sizeof(int));
+	getLeafBytes(src, &entry->rid.slot, sizeof(int));
+	getLeafBytes(src, &entry->numOfIncluded, sizeof(int));
+
+	entry->payload = NULL;
+	if(entry->numOfIncluded > 0)
+	{
+		entry->payload = (Value**)malloc(sizeof(Value*) * entry->numOfIncluded);
+		for(i = 0;i<entry->numOfIncluded;i++)
+		{
+			entry->payload[i] = (Value*)malloc(sizeof(Value));
+			readLeafValue(src, entry->payload[i]);
+		}
+	}
+
+	entry->kv = NULL;
+	getLeafBytes(src, &length, sizeof(int));
+	if(length >= 0)
+	{
+		getLeafBytes(src, &firstPage, sizeof(int));
+		entry->kv = (KVValue*)malloc(sizeof(KVValue) + ((firstPage == NO_PAGE) ? length : 0));
+		entry->kv->length = length;
+		entry->kv->firstPage = firstPage;
+		if(firstPage == NO_PAGE)
+			getLeafBytes(src, entry->kv->data, length);
+	}
+	return entry;
+}
+
+/*
+ * Write the leaf level of count entries in key order, starting with the leaf holding the
+ * entry from. Every leaf is filled with as many entries as fit into a page, so the leaves
+ * in front of the one holding from are the same as before and are not written again.
+ * A leaf of one page is pinned and marked dirty once, an entry larger than a page gets a
+ * leaf of its own whose pages are written with a single writeBlocks
+ */
+static void writeLeafPages (BTree *treeInfo, BTree **entries, int count, int from)
+{
+	SM_FileHandle fh;
+	bool fileOpen = FALSE;
+	char *leaf, *dest;
+	int page = BT_LEAF_FIRST_PAGE, i = 0, j, bytes, entryBytes, numOfPages;
+
+	while(i < count)
+	{
+		//the next entries as long as they fit into the node behind the leaf header
+		bytes = BT_LEAF_HEADER_SIZE + leafEntryBytes(entries[i]);
+		for(j = i + 1;j < count;j++)
+		{
+			entryBytes = leafEntryBytes(entries[j]);
+			if(bytes + entryBytes > treeInfo->nodePages * PAGE_SIZE)
+				break;
+			bytes += entryBytes;
+		}
+		numOfPages = (bytes + PAGE_SIZE - 1) / PAGE_SIZE;
+		if(numOfPages < treeInfo->nodePages)
+			numOfPages = treeInfo->nodePages;
+
+		//a leaf in front of the first changed entry is already in the file
+		if(j <= from)
+		{
+			page += numOfPages;
+			i = j;
+			continue;
+		}
+
+		leaf = (char*)calloc(numOfPages, PAGE_SIZE);
+		((int*)leaf)[BT_LEAF_ENTRIES] = j - i;
+		((int*)leaf)[BT_LEAF_PAGES] = numOfPages;
+		dest = leaf + BT_LEAF_HEADER_SIZE;
+		for(;i<j;i++)
+			writeLeafEntry(&dest, entries[i]);
+
+		if(numOfPages == 1)
+		{
+			pinPage(treeInfo->bm,treeInfo->ph,page);
+			memcpy(treeInfo->ph->data, leaf, PAGE_SIZE);
+			markDirty(treeInfo->bm,treeInfo->ph);
+			unpinPage(treeInfo->bm,treeInfo->ph);
+		}
+		else if(discardPages(treeInfo->bm, page, numOfPages) == RC_OK
+				&& (fileOpen || openPageFile(treeInfo->bm->pageFile, &fh) == RC_OK))
+		{
+			fileOpen = TRUE;
+			ensureCapacity(page + numOfPages, &fh);
+			writeBlocks(page, numOfPages, &fh, leaf);
+		}
+		free(leaf);
+		page += numOfPages;
+	}
+	if(fileOpen)
+		closePageFile(&fh);
+
+	treeInfo->numOfLeafPages = page - BT_LEAF_FIRST_PAGE;
+	treeInfo->firstDirtyEntry = -1;
+
+	pinPage(treeInfo->bm,treeInfo->ph,BT_HEADER_PAGE);
+	((int*)treeInfo->ph->data)[BT_HEADER_ENTRIES] = count;
+	((int*)treeInfo->ph->data)[BT_HEADER_LEAF_PAGES] = treeInfo->numOfLeafPages;
+	markDirty(treeInfo->bm,treeInfo->ph);
+	unpinPage(treeInfo->bm,treeInfo->ph);
+}
+
+/*
+ * Write the entries changed since the leaves were last written, the ART engine has
+ * no positions and writes all of its keys. The Bloom filter follows the leaves,
+ * so it moves with them when their number of pages changed
+ */
+static void writeEntries (BTree *treeInfo)
+{
+	int numOfLeafPages = treeInfo->numOfLeafPages;
+
+	if(treeInfo->firstDirtyEntry < 0)
+		return;
+
+	if(treeInfo->engine == IE_ART)
+	{
+		ArtCursor cursor;
+		BTree **entries = (BTree**)malloc(sizeof(BTree*) * (treeInfo->art->numOfKeys + 1));
+		int count = 0;
+
+		artCursorInit(&cursor, treeInfo->art, 0);
+		while((entries[count] = (BTree*)artCursorNext(&cursor)) != NULL)
+			count++;
+		artCursorClose(&cursor);
+
+		writeLeafPages(treeInfo, entries, count, 0);
+		free(entries);
+	}
+	else
+		writeLeafPages(treeInfo, treeInfo->entries, treeInfo->numOfKeys, treeInfo->firstDirtyEntry);
+
+	if(treeInfo->bloom != NULL && treeInfo->numOfLeafPages != numOfLeafPages)
+		writeBloomFilter(treeInfo);
+}
+
+/*
+ * Read the leaf level written by writeLeafPages into the entries of the tree,
+ * or into the radix tree of the ART engine. A leaf of one page is read with a pin,
+ * a larger one with a single readBlocks
+ */
+static void readEntries (BTree *treeInfo)
+{
+	SM_FileHandle fh;
+	bool fileOpen = FALSE;
+	char *leaf, *src;
+	int page = BT_LEAF_FIRST_PAGE, i, count, numOfPages, length;
+	unsigned char *bytes;
+
+	while(page < BT_LEAF_FIRST_PAGE + treeInfo->numOfLeafPages)
+	{
+		pinPage(treeInfo->bm,treeInfo->ph,page);
+		count = ((int*)treeInfo->ph->data)[BT_LEAF_ENTRIES];
+		numOfPages = ((int*)treeInfo->ph->data)[BT_LEAF_PAGES];
+		if(numOfPages < 1)
+			numOfPages = 1;
+		leaf = (char*)malloc(numOfPages * PAGE_SIZE);
+		memcpy(leaf, treeInfo->ph->data, PAGE_SIZE);
+		unpinPage(treeInfo->bm,treeInfo->ph);
+
+		if(numOfPages > 1 && discardPages(treeInfo->bm, page, numOfPages) == RC_OK
+				&& (fileOpen || openPageFile(treeInfo->bm->pageFile, &fh) == RC_OK))
+		{
+			fileOpen = TRUE;
+			readBlocks(page, numOfPages, &fh, leaf);
+		}
+
+		src = leaf + BT_LEAF_HEADER_SIZE;
+		for(i = 0;i<count;i++)
+		{
+			BTree *entry = readLeafEntry(&src);
+
+			if(treeInfo->engine == IE_ART)
+			{
+				bytes = encodeKey(&entry->value, &length);
+				artInsert(treeInfo->art, bytes, length, entry);
+				free(bytes);
+			}
+			else
+			{
+				ensureKeyCapacity(treeInfo, treeInfo->numOfKeys + 1);
+				treeInfo->entries[treeInfo->numOfKeys++] = entry;
+			}
+		}
+		free(leaf);
+		page += numOfPages;
+	}
+	if(fileOpen)
+		closePageFile(&fh);
+}
+
+/*
+ * Bytes of a condition in the header page: every expression starts with its type,
+ * followed by the operator type and the arguments, the constant or the attribute
+ */
+static int conditionBytes (Expr *expr)
+{
+	switch(expr->type)
+	{
+	case EXPR_OP:
+		if(expr->expr.op->type == OP_BOOL_NOT)
+			return 2 * sizeof(int) + conditionBytes(expr->expr.op->args[0]);
+		return 2 * sizeof(int) + conditionBytes(expr->expr.op->args[0]) + conditionBytes(expr->expr.op->args[1]);
+	case EXPR_CONST:
+		return sizeof(int) + leafValueBytes(expr->expr.cons);
+	default:
+		return 2 * sizeof(int);
+	}
+}
+
+static void writeCondition (char **dest, Expr *expr)
+{
+	int type = expr->type, opType;
+
+	putLeafBytes(dest, &type, sizeof(int));
+	switch(expr->type)
+	{
+	case EXPR_OP:
+		opType = expr->expr.op->type;
+		putLeafBytes(dest, &opType, sizeof(int));
+		writeCondition(dest, expr->expr.op->args[0]);
+		if(expr->expr.op->type != OP_BOOL_NOT)
+			writeCondition(dest, expr->expr.op->args[1]);
+		break;
+	case EXPR_CONST:
+		writeLeafValue(dest, expr->expr.cons);
+		break;
+	default:
+		putLeafBytes(dest, &expr->expr.attrRef, sizeof(int));
+		break;
+	}
+}
+
+static Expr *readCondition (char **src)
+{
+	Expr *expr, *left, *right;
+	Value *cons;
+	int type, opType, attrRef;
+
+	getLeafBytes(src, &type, sizeof(int));
+	switch(type)
+	{
+	case EXPR_OP:
+		getLeafBytes(src, &opType, sizeof(int));
+		left = readCondition(src);
+		if(opType == OP_BOOL_NOT)
+		{
+			MAKE_UNOP_EXPR(expr, left, opType);
+		}
+		else
+		{
+			right = readCondition(src);
+			MAKE_BINOP_EXPR(expr, left, right, opType);
+		}
+		break;
+	case EXPR_CONST:
+		cons = (Value*)malloc(sizeof(Value));
+		readLeafValue(src, cons);
+		MAKE_CONS(expr, cons);
+		break;
+	default:
+		getLeafBytes(src, &attrRef, sizeof(int));
+		MAKE_ATTRREF(expr, attrRef);
+		break;
+	}
+	return expr;
+}
+
+// init and shutdown index manager
+/*
+ * This is function is used to Initialize Index Manager
+ */
+RC initIndexManager (void *mgmtData)
+{
+	return RC_OK;
+}
+
+/*
+ * This is function is used to shut down the index manager,
+ * also free's the memory allocated during the process
+ */
+
+RC shutdownIndexManager()
+{
+	//every index frees its keys when it is closed
+	return RC_OK;
+}
+
+// create, destroy, open, and close an btree index
+
+/*
+ * This function is used to Create A B+ Tree
+ * all the attributes related to the tree are initialized
+ */
+RC createBtree (char *idxId, DataType keyType, int n)
+{
+	return createBtreeWithPayload(idxId, keyType, n, 0, NULL);
+}
+
+/*
+ * Create the index file with its header page and start with an empty set of entries
+ */
+static RC createIndex (char *idxId, DataType keyType, int n, int nodePages, IndexEngine engine, int numIncluded, DataType *includedTypes)
+{
+	SM_FileHandle fh;
+	int i;
+
+	if(engine != IE_BTREE && engine != IE_ART && engine != IE_HASH)
+	{
+		THROW(RC_IM_UNKNOWN_ENGINE, "unknown index engine");
+	}
+
+	//a node holds at least one key, the node counts divide by N
+	if(n < 1)
+	{
+		THROW(RC_IM_N_TO_LAGE, "a node holds at least one key");
+	}
+
+	if(numIncluded < 0 || numIncluded > BT_MAX_INCLUDED)
+	{
+		THROW(RC_IM_TOO_MANY_INCLUDED, "too many included columns for the index header");
+	}
+
+	SM_PageHandle ph = calloc(PAGE_SIZE,sizeof(char));
+
+	//Create a B-tree, using page file
+	if(createPageFile(idxId) != RC_OK)
+	{
+		free(ph);
+		return RC_FILE_NOT_FOUND;
+	}
+
+	openPageFile(idxId,&fh);
+
+	//confirm the number of pages present
+	ensureCapacity(1,&fh);
+
+	//the header page has the number of keys that can be inserted into a single Node,
+	//the key type, the number of entries and of leaf pages
+	((int*)ph)[BT_HEADER_N] = n;
+	((int*)ph)[BT_HEADER_KEYTYPE] = keyType;
+	((int*)ph)[BT_HEADER_ENTRIES] = 0;
+	((int*)ph)[BT_HEADER_ENGINE] = engine;
+	((int*)ph)[BT_HEADER_NODE_PAGES] = nodePages;
+	((int*)ph)[BT_HEADER_TABLE_ATTR] = -1;
+
+	//followed by the datatypes of the included columns
+	((int*)ph)[BT_HEADER_INCLUDED] = numIncluded;
+	for(i = 0;i<numIncluded;i++)
+	{
+		((int*)ph)[BT_HEADER_INCLUDED_TYPES + i] = includedTypes[i];
+	}
+
+	//write the header to the page
+	writeBlock(BT_HEADER_PAGE,&fh,ph);
+
+	closePageFile(&fh);
+	free(ph);
+
+	//a new index has no leaves and no values in overflow pages yet
+	destroyOverflowFile(idxId);
+
+	return RC_OK;
+}
+
+/*
+ * This function is used to Create an index served by the given engine,
+ * IE_BTREE gives the same index as createBtree and IE_ART keeps the keys
+ * in an Adaptive Radix Tree. The engine is stored in the header page,
+ * openBtree reads it and every index function dispatches on it
+ */
+RC createBtreeWithEngine (char *idxId, DataType keyType, int n, IndexEngine engine)
+{
+	return createIndex(idxId, keyType, n, 1, engine, 0, NULL);
+}
+
+/*
+ * This function is used to Create a B+ Tree whose nodes span nodePages pages,
+ * N is the number of key slots (key and RID) that fit in the node.
+ * Larger nodes give a shallower tree. Every leaf is written to nodePages contiguous
+ * pages with one writeBlocks and read back with one readBlocks
+ */
+RC createBtreeWithNodeSize (char *idxId, DataType keyType, int nodePages)
+{
+	if(nodePages < 1 || nodePages > BT_MAX_NODE_PAGES)
+	{
+		THROW(RC_IM_N_TO_LAGE, "a node spans 1 to BT_MAX_NODE_PAGES pages");
+	}
+
+	return createIndex(idxId, keyType, nodePages * PAGE_SIZE / BT_NODE_SLOT_SIZE, nodePages, IE_BTREE, 0, NULL);
+}
+
+/*
+ * This function is used to Create A covering B+ Tree,
+ * every entry also stores numIncluded columns of the given datatypes,
+ * so index-only queries get them from nextEntryWithPayload without reading the table
+ */
+RC createBtreeWithPayload (char *idxId, DataType keyType, int n, int numIncluded, DataType *includedTypes)
+{
+	return createIndex(idxId, keyType, n, 1, IE_BTREE, numIncluded, includedTypes);
+}
+
+/*
+ * Open a frozen export, the file is only mapped, nothing is read
+ * and no buffer pool is created
+ */
+static RC openFrozenBtree (BTreeHandle **tree, char *idxId)
+{
+	FrozenIndex *frozen = frozenOpen(idxId);
+	BTree *treeInfo;
+
+	if(frozen == NULL)
+	{
+		THROW(RC_FILE_NOT_FOUND, "could not map the frozen index file");
+	}
+
+	//only the engine and the mapping are used, every other part stays empty
+	treeInfo = (BTree*)calloc(1, sizeof(BTree));
+	treeInfo->engine = IE_FROZEN;
+	treeInfo->frozen = frozen;
+	treeInfo->openHandles = 1;
+	treeInfo->tableAttr = -1;
+	treeInfo->maxNumOfKeysPerNode = frozen->n;
+
+	*tree = (BTreeHandle*)malloc(sizeof(BTreeHandle));
+	(*tree)->idxId = idxId;
+	(*tree)->keyType = frozen->keyType;
+	(*tree)->mgmtData = treeInfo;
+	return RC_OK;
+}
+
+/*
+ * This function is used to open the B-Tree alread created above,
+ * it read the value from the page file regarding the "N"
+ * and stores in the BTREE structure created attributes.
+ * An index that is open already gives another handle on the same tree
+ */
+RC openBtree (BTreeHandle **tree, char *idxId)
+{
+	SM_FileHandle fh;
+	BTree *treeInfo;
+
+	//a frozen export is not a page file
+	if(isFrozenIndexFile(idxId))
+	{
+		return openFrozenBtree(tree, idxId);
+	}
+
+	//Open a PageFile
+	if(openPageFile(idxId,&fh) != RC_OK)
+	{
+		return RC_FILE_NOT_FOUND;
+	}
+
+	//an index opened already is shared, writes through any handle are seen by all of them
+	for(treeInfo = openTrees;treeInfo != NULL;treeInfo = treeInfo->nextOpen)
+	{
+		if(strcmp(treeInfo->fileName, idxId) == 0)
+		{
+			closePageFile(&fh);
+			treeInfo->openHandles++;
+			*tree = (BTreeHandle*)malloc(sizeof(BTreeHandle));
+			(*tree)->idxId = idxId;
+			(*tree)->keyType = treeInfo->keyType;
+			(*tree)->mgmtData = treeInfo;
+			return RC_OK;
+		}
+	}
+
+	//close the page file, the buffer pool opens it on demand
+	closePageFile(&fh);
+
+	//Create a Btree Handler
+	*tree = (BTreeHandle*)malloc(sizeof(BTreeHandle));
+	(*tree)->idxId = idxId;
+
+	//Create a Tree Information Node, it owns the entries of the index
+	treeInfo = (BTree*)calloc(1, sizeof(BTree));
+	treeInfo->fileName = (char*)malloc(strlen(idxId) + 1);
+	strcpy(treeInfo->fileName, idxId);
+	treeInfo->openHandles = 1;
+	treeInfo->nextOpen = openTrees;
+	openTrees = treeInfo;
+
+	//Make Buffer Pool & Page Handle to access the pages
+	treeInfo->bm = MAKE_POOL();
+	treeInfo->ph = MAKE_PAGE_HANDLE();
+
+	//initialize the Buffer Pool
+	initBufferPool(treeInfo->bm,treeInfo->fileName,6,RS_FIFO,NULL);
+
+	//Pin the page to be accessed to get data
+	pinPage(treeInfo->bm,treeInfo->ph,BT_HEADER_PAGE);
+
+	//store the page data i.e. N value and the key type
+	treeInfo->maxNumOfKeysPerNode = ((int*)treeInfo->ph->data)[BT_HEADER_N];
+	(*tree)->keyType = ((int*)treeInfo->ph->data)[BT_HEADER_KEYTYPE];
+	treeInfo->keyType = (*tree)->keyType;
+	treeInfo->engine = ((int*)treeInfo->ph->data)[BT_HEADER_ENGINE];
+
+	int bloomBitsPerKey = ((int*)treeInfo->ph->data)[BT_HEADER_BLOOM_BITS];
+	int bloomBlocks = ((int*)treeInfo->ph->data)[BT_HEADER_BLOOM_BLOCKS];
+	int i;
+
+	treeInfo->numOfLeafPages = ((int*)treeInfo->ph->data)[BT_HEADER_LEAF_PAGES];
+	treeInfo->nodePages = ((int*)treeInfo->ph->data)[BT_HEADER_NODE_PAGES];
+	if(treeInfo->nodePages < 1)
+		treeInfo->nodePages = 1;
+	treeInfo->firstDirtyEntry = -1;
+
+	//datatypes of the included columns
+	treeInfo->numOfIncluded = ((int*)treeInfo->ph->data)[BT_HEADER_INCLUDED];
+	treeInfo->includedTypes = (DataType*)malloc(sizeof(DataType) * (treeInfo->numOfIncluded + 1));
+	for(i = 0;i<treeInfo->numOfIncluded;i++)
+	{
+		treeInfo->includedTypes[i] = ((int*)treeInfo->ph->data)[BT_HEADER_INCLUDED_TYPES + i];
+	}
+
+	//the attribute and the condition of an index built on a table
+	treeInfo->tableAttr = ((int*)treeInfo->ph->data)[BT_HEADER_TABLE_ATTR];
+	if(((int*)treeInfo->ph->data)[BT_HEADER_COND_BYTES] > 0)
+	{
+		char *cond = treeInfo->ph->data + BT_HEADER_COND * sizeof(int);
+		treeInfo->cond = readCondition(&cond);
+	}
+	treeInfo->payload = NULL;
+	treeInfo->buffer = NULL;
+	treeInfo->learned = NULL;
+	treeInfo->frozen = NULL;
+	treeInfo->overflow = NULL;
+
+	//copy-on-write stays off until setCopyOnWrite, the version continues from the header
+	treeInfo->versions = (EntryVersions*)calloc(1, sizeof(EntryVersions));
+	treeInfo->versions->version = ((int*)treeInfo->ph->data)[BT_HEADER_VERSION];
+
+	//Node Counter to count number of Nodes
+	treeInfo->nodeCounter=0;
+
+	//store the entire data into the management data for the Tree Handle
+	(*tree)->mgmtData = treeInfo;
+
+	//unpin the page after read operation is performed
+	unpinPage(treeInfo->bm,treeInfo->ph);
+
+	//load the entries from the leaf pages, the ART engine inserts them into its radix tree
+	if(treeInfo->engine == IE_ART)
+		treeInfo->art = artCreate();
+	if(treeInfo->engine == IE_BTREE || treeInfo->engine == IE_ART)
+		readEntries(treeInfo);
+
+	//load the Bloom filter, if the index has one
+	treeInfo->bloom = NULL;
+	readBloomFilter(treeInfo, bloomBitsPerKey, bloomBlocks);
+
+	//hot keys are added to the adaptive hash index as findKey sees them
+	treeInfo->ahi = createAdaptiveHashIndex();
+
+	treeInfo->eytzinger = NULL;
+
+	//the key histogram of estimateRangeCount is kept up to date from here on
+	treeInfo->histogram = NULL;
+	if(treeInfo->engine == IE_BTREE)
+	{
+		treeInfo->histogram = (KeyHistogram*)calloc(1, sizeof(KeyHistogram));
+		buildKeyHistogram(treeInfo);
+	}
+
+	//DT_INT keys are searched by interpolation while they look uniform
+	treeInfo->interpolation = NULL;
+	if(treeInfo->engine == IE_BTREE && (*tree)->keyType == DT_INT)
+	{
+		treeInfo->interpolation = (InterpolationSearch*)calloc(1, sizeof(InterpolationSearch));
+		treeInfo->interpolation->uniform = sampleUniformKeys(treeInfo);
+		treeInfo->interpolation->valid = TRUE;
+	}
+
+	//the hash engine reads its directory from the index pages
+	treeInfo->hash = NULL;
+	if(treeInfo->engine == IE_HASH)
+		treeInfo->hash = hashOpen(treeInfo->bm, BT_HASH_META_PAGE);
+
+	return RC_OK;
+}
+
+/*
+ * Used to close the B-Tree
+ */
+RC closeBtree (BTreeHandle *tree)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	BTree **open;
+
+	//the tree stays until its last handle is closed
+	free(tree);
+	if(--treeInfo->openHandles > 0)
+		return RC_OK;
+
+	for(open = &openTrees;*open != NULL;open = &(*open)->nextOpen)
+	{
+		if(*open == treeInfo)
+		{
+			*open = treeInfo->nextOpen;
+			break;
+		}
+	}
+
+	//apply the pending messages and write the changed leaves before the tree goes away
+	freeMessageBuffer(treeInfo);
+	if(treeInfo->engine == IE_BTREE || treeInfo->engine == IE_ART)
+		writeEntries(treeInfo);
+
+	//persist the Bloom filter into its pages
+	if(treeInfo->bloom != NULL)
+	{
+		writeBloomFilter(treeInfo);
+		freeBloomFilter(treeInfo->bloom);
+	}
+
+	if(treeInfo->hash != NULL)
+		hashClose(treeInfo->hash);
+	if(treeInfo->frozen != NULL)
+		frozenClose(treeInfo->frozen);
+
+	closeOverflowStore(treeInfo);
+	freeLearnedIndex(treeInfo);
+	free(treeInfo->interpolation);
+	freeEytzingerLayout(treeInfo);
+	freeKeyHistogram(treeInfo);
+	if(treeInfo->versions != NULL)
+		freeEntryVersions(treeInfo);
+	freeAllEntries(treeInfo);
+	if(treeInfo->art != NULL)
+		freeArtIndex(treeInfo);
+	free(treeInfo->ahi);
+	free(treeInfo->includedTypes);
+	if(treeInfo->cond != NULL)
+		freeExpr(treeInfo->cond);
+
+	//flush the header and release the buffer pool, a frozen export has none
+	if(treeInfo->bm != NULL)
+		shutdownBufferPool(treeInfo->bm);
+	free(treeInfo->bm);
+	free(treeInfo->ph);
+	free(treeInfo->fileName);
+	free(treeInfo);
+	return RC_OK;
+}
+
+/*
+ * This function is used to delete the tree
+ * i.e. destroy the page file created and free all memory
+ */
+RC deleteBtree (char *idxId)
+{
+	//the entries live in the index pages, an open index freed them when it was closed
+	destroyPageFile(idxId);
+	destroyOverflowFile(idxId);
+	return RC_OK;
+}
+
+/*
+ * This function exports the index into a frozen read-only file:
+ * every entry packed in key order into fixed size slots behind a header page,
+ * so the file is 100% full. openBtree recognizes the file, maps it with mmap
+ * instead of creating a buffer pool and serves findKey and the scans from the
+ * mapping, which many processes can share through the page cache.
+ * Writes to the opened export return RC_IM_INDEX_READ_ONLY
+ */
+RC exportFrozenBtree (BTreeHandle *tree, char *fileName)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	FrozenWriter *writer;
+	int i, keyWidth = sizeof(int);
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "only the B+ tree engine can be exported");
+	}
+
+	flushMessageBuffer(treeInfo);
+
+	//64 bit keys take 8 bytes, string slots are as wide as the longest key and its terminating 0
+	if(tree->keyType == DT_INT64 || tree->keyType == DT_DOUBLE)
+		keyWidth = 8;
+	else if(tree->keyType == DT_STRING)
+	{
+		for(i = 0;i<treeInfo->numOfKeys;i++)
+		{
+			if((int)strlen(treeInfo->entries[i]->value.v.stringV) + 1 > keyWidth)
+				keyWidth = strlen(treeInfo->entries[i]->value.v.stringV) + 1;
+		}
+		keyWidth = (keyWidth + 3) & ~3;
+	}
+
+	writer = frozenWriterOpen(fileName, tree->keyType, treeInfo->maxNumOfKeysPerNode, treeInfo->numOfKeys, keyWidth);
+	if(writer == NULL)
+	{
+		return RC_FILE_NOT_FOUND;
+	}
+
+	for(i = 0;i<treeInfo->numOfKeys;i++)
+	{
+		frozenWriterAppend(writer, &treeInfo->entries[i]->value, treeInfo->entries[i]->rid);
+	}
+	return frozenWriterClose(writer);
+}
+
+/*
+ * Add the key of a record to a table index build
+ */
+static void addBuildEntry (TableIndexBuild *build, Value *key, RID rid)
+{
+	if(build->count == build->capacity)
+	{
+		build->capacity = (build->capacity == 0) ? 64 : build->capacity * 2;
+		build->keys = (Value**)realloc(build->keys, sizeof(Value*) * build->capacity);
+		build->rids = (RID*)realloc(build->rids, sizeof(RID) * build->capacity);
+	}
+	build->keys[build->count] = key;
+	build->rids[build->count++] = rid;
+}
+
+static void freeBuildEntries (TableIndexBuild *build)
+{
+	int i;
+
+	for(i = 0;i<build->count;i++)
+		freeVal(build->keys[i]);
+	free(build->keys);
+	free(build->rids);
+}
+
+/*
+ * Store the attribute and the condition of an index built on a table in its header page,
+ * the tree reads its own copy of the condition back from the page
+ */
+static void setTableIndex (BTree *treeInfo, int attrNum, Expr *cond)
+{
+	char *dest, *src;
+
+	pinPage(treeInfo->bm,treeInfo->ph,BT_HEADER_PAGE);
+	((int*)treeInfo->ph->data)[BT_HEADER_TABLE_ATTR] = attrNum;
+	((int*)treeInfo->ph->data)[BT_HEADER_COND_BYTES] = (cond != NULL) ? conditionBytes(cond) : 0;
+	if(cond != NULL)
+	{
+		dest = src = treeInfo->ph->data + BT_HEADER_COND * sizeof(int);
+		writeCondition(&dest, cond);
+		treeInfo->cond = readCondition(&src);
+	}
+	treeInfo->tableAttr = attrNum;
+	markDirty(treeInfo->bm,treeInfo->ph);
+	unpinPage(treeInfo->bm,treeInfo->ph);
+}
+
+/*
+ * Build the index idxId on the attribute attrNum of the rows of a table satisfying cond,
+ * all the rows when cond is NULL. The table is scanned once, the (key, RID) pairs
+ * are sorted and bulk loaded by insertKeys. The index is only kept when every key
+ * went in, after a duplicate key or an error it is deleted again.
+ * The attribute and the condition are stored with the index for insertTableRecord
+ */
+static RC buildIndexOnTable (RM_TableData *rel, int attrNum, char *idxId, Expr *cond)
+{
+	TableIndexBuild scanned = { NULL, NULL, 0, 0 };
+	RM_ScanHandle scan;
+	Record record;
+	BTreeHandle *tree;
+	Value *key;
+	RC rc;
+
+	if(attrNum < 0 || attrNum >= rel->schema->numAttr)
+	{
+		THROW(RC_IM_NO_SUCH_ATTRIBUTE, "the table has no such attribute");
+	}
+
+	if(cond != NULL && conditionBytes(cond) > BT_COND_MAX_BYTES)
+	{
+		THROW(RC_IM_CONDITION_TOO_LARGE, "the condition does not fit into the header page");
+	}
+
+	rc = createBtreeWithNodeSize(idxId, rel->schema->dataTypes[attrNum], 1);
+	if(rc != RC_OK)
+		return rc;
+
+	//the scan of the record manager evaluates the condition of a partial index
+	startScan(rel, &scan, cond);
+	while(next(&scan, &record) == RC_OK)
+	{
+		if(getAttr(&record, rel->schema, attrNum, &key) == RC_OK)
+			addBuildEntry(&scanned, key, record.id);
+		free(record.data);
+	}
+	closeScan(&scan);
+
+	//one sort and one merge for all the records of the table
+	rc = openBtree(&tree, idxId);
+	if(rc == RC_OK)
+	{
+		setTableIndex((BTree*)tree->mgmtData, attrNum, cond);
+		rc = insertKeys(tree, scanned.keys, scanned.rids, scanned.count);
+		closeBtree(tree);
+	}
+	freeBuildEntries(&scanned);
+
+	//no half built index is left behind
+	if(rc != RC_OK)
+		deleteBtree(idxId);
+	return rc;
+}
+
+/*
+ * This function is used to create the index idxId on the attribute attrNum of a table,
+ * see buildIndexOnTable. The index is unique: when a key is found in two records
+ * no index is created and RC_IM_KEY_ALREADY_EXISTS is returned
+ */
+RC createIndexOnTable (RM_TableData *rel, int attrNum, char *idxId)
+{
+	return buildIndexOnTable(rel, attrNum, idxId, NULL);
+}
+
+/*
+ * This function is used to create a partial index: only the rows for which
+ * evalExpr gives TRUE for cond are indexed, so the size of the index and the
+ * cost of building it follow the rows the queries use instead of the whole table.
+ * The condition is stored with the index: records inserted into the table later are
+ * added with insertTableRecord, which applies it. insertKey does not know the record
+ * and adds any key it is given
+ */
+RC createPartialIndexOnTable (RM_TableData *rel, int attrNum, char *idxId, Expr *cond)
+{
+	return buildIndexOnTable(rel, attrNum, idxId, cond);
+}
+
+/*
+ * This function is used to add a record inserted into a table to an index built on it
+ * by createIndexOnTable or createPartialIndexOnTable. The key is the attribute the index
+ * was built on, a record outside the condition of a partial index is not added
+ * and RC_OK is returned
+ */
+RC insertTableRecord (BTreeHandle *tree, RM_TableData *rel, Record *record)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	Value *key, *matches;
+	RC rc;
+
+	if(treeInfo->tableAttr < 0 || treeInfo->tableAttr >= rel->schema->numAttr)
+	{
+		THROW(RC_IM_NO_SUCH_ATTRIBUTE, "the index was not built on an attribute of the table");
+	}
+
+	if(treeInfo->cond != NULL)
+	{
+		rc = evalExpr(record, rel->schema, treeInfo->cond, &matches);
+		if(rc != RC_OK)
+			return rc;
+		if(matches->dt != DT_BOOL || !matches->v.boolV)
+		{
+			freeVal(matches);
+			return RC_OK;
+		}
+		freeVal(matches);
+	}
+
+	rc = getAttr(record, rel->schema, treeInfo->tableAttr, &key);
+	if(rc != RC_OK)
+		return rc;
+	rc = insertKey(tree, key, record->id);
+	freeVal(key);
+	return rc;
+}
+
+// access information about a b-tree
+/*
+ * Number of nodes of a B+ tree holding keys keys in full nodes of N keys:
+ * leaves hold N keys each, every inner level has N+1 children per node
+ */
+static int countTreeNodes (int keys, int n)
+{
+	int levelNodes = (keys + n - 1) / n;
+	int numOfNodes = levelNodes;
+
+	while(levelNodes > 1)
+	{
+		levelNodes = (levelNodes + n) / (n + 1);
+		numOfNodes += levelNodes;
+	}
+	return numOfNodes;
+}
+
+/*
+ * Get the total Number of Nodes in the B+Tree formed
+ */
+RC getNumNodes (BTreeHandle *tree, int *result)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	switch(treeInfo->engine)
+	{
+	case IE_ART:
+		//inner nodes of the radix tree, a single key is a lone leaf
+		*result = (treeInfo->art->numOfNodes == 0 && treeInfo->art->numOfKeys > 0) ? 1 : treeInfo->art->numOfNodes;
+		return RC_OK;
+	case IE_HASH:
+		//bucket and directory pages
+		*result = treeInfo->hash->numOfBuckets + treeInfo->hash->numOfDirPages;
+		return RC_OK;
+	case IE_FROZEN:
+		//the export is packed, every node is full
+		*result = countTreeNodes(treeInfo->frozen->numOfKeys, treeInfo->maxNumOfKeysPerNode);
+		return RC_OK;
+	default:
+		break;
+	}
+
+	flushMessageBuffer(treeInfo);
+	*result = countTreeNodes(treeInfo->numOfKeys, treeInfo->maxNumOfKeysPerNode);
+
+	return RC_OK;
+}
+
+/*
+ * Total number of entries in the B+ -Tree i.e. the Number of Keys
+ */
+RC getNumEntries (BTreeHandle *tree, int *result)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	switch(treeInfo->engine)
+	{
+	case IE_ART:
+		*result = treeInfo->art->numOfKeys;
+		return RC_OK;
+	case IE_HASH:
+		*result = treeInfo->hash->numOfKeys;
+		return RC_OK;
+	case IE_FROZEN:
+		*result = treeInfo->frozen->numOfKeys;
+		return RC_OK;
+	default:
+		break;
+	}
+
+	//as we have stored the values for every insert we can utilize that directly here
+	flushMessageBuffer(treeInfo);
+	*result = treeInfo->numOfKeys;
+	return RC_OK;
+}
+
+/*
+ * Gets the type of Key in the tree inserted and stores it in the result
+ */
+RC getKeyType (BTreeHandle *tree, DataType *result)
+{
+	*result = tree->keyType;
+	return RC_OK;
+}
+
+/*
+ * Fill the levels and fill factors of the stats for keys packed into nodes the way
+ * countTreeNodes counts them: leaves of n keys and inner nodes of n + 1 children,
+ * where only the last node of a level may hold less
+ */
+static void computeNodeStats (int keys, int n, BTreeStats *stats)
+{
+	int levelNodes[BT_STATS_MAX_LEVELS];
+	int nodes, children, i;
+	double lastFill, fillSum;
+
+	if(keys == 0)
+		return;
+
+	//the leaves first, then every inner level up to the root
+	nodes = (keys + n - 1) / n;
+	lastFill = (double)(keys - (nodes - 1) * n) / n;
+	levelNodes[stats->height++] = nodes;
+	fillSum = (nodes - 1) + lastFill;
+	stats->minFillFactor = lastFill;
+	while(nodes > 1 && stats->height < BT_STATS_MAX_LEVELS)
+	{
+		children = nodes;
+		nodes = (children + n) / (n + 1);
+		lastFill = (double)(children - (nodes - 1) * (n + 1) - 1) / n;
+		levelNodes[stats->height++] = nodes;
+		fillSum += (nodes - 1) + lastFill;
+		if(lastFill < stats->minFillFactor)
+			stats->minFillFactor = lastFill;
+	}
+
+	for(i = 0;i<stats->height;i++)
+	{
+		stats->nodesPerLevel[i] = levelNodes[stats->height - 1 - i];
+		stats->numOfNodes += stats->nodesPerLevel[i];
+	}
+	stats->avgFillFactor = fillSum / stats->numOfNodes;
+}
+
+/*
+ * Memory of an entry, its string key, its payload and its value
+ */
+static size_t entryBytes (BTree *entry)
+{
+	size_t bytes = sizeof(BTree) + stringBytes(&entry->value);
+	int i;
+
+	for(i = 0;i<entry->numOfIncluded;i++)
+		bytes += sizeof(Value*) + sizeof(Value) + stringBytes(entry->payload[i]);
+	if(entry->kv != NULL)
+		bytes += sizeof(KVValue) + ((entry->kv->firstPage == NO_PAGE) ? entry->kv->length : 0);
+	return bytes;
+}
+
+/*
+ * Add the pages of a buffer pool's file and those of them held in its frames
+ */
+static void countResidentPages (BM_BufferPool *bm, int *resident, int *total)
+{
+	SM_FileHandle fh;
+	PageNumber *frames;
+	int i;
+
+	if(openPageFile(bm->pageFile,&fh) != RC_OK)
+		return;
+	*total += fh.totalNumPages;
+	closePageFile(&fh);
+
+	frames = getFrameContents(bm);
+	for(i = 0;i<bm->numPages;i++)
+	{
+		if(frames[i] != NO_PAGE)
+			(*resident)++;
+	}
+	free(frames);
+}
+
+/*
+ * This function returns the shape of a B+ tree index for capacity planning:
+ * the nodes of every level, their fill factors, the memory per entry,
+ * the fragmentation of the entries and the share of the pages in the buffer pool.
+ * Entries are fragmented when the next key is not the next entry in memory,
+ * defragmentBtree brings the fragmentation back to 0
+ */
+RC getBtreeStats (BTreeHandle *tree, BTreeStats *stats)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	size_t bytes = 0;
+	int i, fragmented = 0, resident = 0, total = 0;
+
+	memset(stats, 0, sizeof(BTreeStats));
+
+	//a frozen export is packed in key order and read through the page cache
+	if(treeInfo->engine == IE_FROZEN)
+	{
+		computeNodeStats(treeInfo->frozen->numOfKeys, treeInfo->maxNumOfKeysPerNode, stats);
+		stats->bytesPerEntry = treeInfo->frozen->entrySize;
+		stats->residentPages = frozenResidentShare(treeInfo->frozen);
+		return RC_OK;
+	}
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "statistics need the B+ tree layout");
+	}
+
+	flushMessageBuffer(treeInfo);
+	computeNodeStats(treeInfo->numOfKeys, treeInfo->maxNumOfKeysPerNode, stats);
+
+	for(i = 0;i<treeInfo->numOfKeys;i++)
+	{
+		bytes += entryBytes(treeInfo->entries[i]);
+		if(i > 0 && treeInfo->entries[i] != treeInfo->entries[i - 1] + 1)
+			fragmented++;
+	}
+	if(treeInfo->numOfKeys > 0)
+		stats->bytesPerEntry = (double)(bytes + sizeof(BTree*) * treeInfo->allocatedKeys) / treeInfo->numOfKeys;
+	if(treeInfo->numOfKeys > 1)
+		stats->fragmentation = (double)fragmented / (treeInfo->numOfKeys - 1);
+
+	countResidentPages(treeInfo->bm, &resident, &total);
+	if(treeInfo->overflow != NULL)
+		countResidentPages(treeInfo->overflow->bm, &resident, &total);
+	if(total > 0)
+		stats->residentPages = (double)resident / total;
+
+	return RC_OK;
+}
+
+// index access
+/*
+ * Find the entry of a key in the B+ tree engine, the way findKey and kvGet do:
+ * the Bloom filter, the write buffer, the adaptive hash index and then the search.
+ * returns NULL when the key is not in the tree
+ */
+static BTree *lookupEntry (BTree *treeInfo, Value *key)
+{
+	int found, pos;
+	unsigned long long hash;
+
+	//a negative answer of the Bloom filter is exact, skip the search
+	if(treeInfo->bloom != NULL && !bloomMayContain(treeInfo->bloom, key))
+	{
+		return NULL;
+	}
+
+	//a pending message of the key is newer than the entries
+	pos = findPendingMessage(treeInfo->buffer, key);
+	if(pos >= 0)
+	{
+		if(treeInfo->buffer->messages[pos].type == BT_MSG_DELETE)
+			return NULL;
+		return treeInfo->buffer->messages[pos].entry;
+	}
+
+	//hot keys are found directly through the adaptive hash index
+	hash = hashKey(key);
+	pos = adaptiveHashLookup(treeInfo, key, hash);
+	if(pos < 0)
+	{
+		pos = locateKey(treeInfo, key, &found);
+
+		if(!found)
+		{
+			return NULL;
+		}
+
+		adaptiveHashRecord(treeInfo->ahi, hash, pos);
+	}
+	return treeInfo->entries[pos];
+}
+
+/*
+ * Insert a new entry at its position, the greater keys are shifted right
+ * on a copy of the entries if a scan reads the current ones
+ */
+static void insertEntryAt (BTree *treeInfo, int pos, BTree *entry)
+{
+	detachCurrentVersion(treeInfo, TRUE);
+	ensureKeyCapacity(treeInfo, treeInfo->numOfKeys + 1);
+	memmove(&treeInfo->entries[pos + 1], &treeInfo->entries[pos], sizeof(BTree*) * (treeInfo->numOfKeys - pos));
+	treeInfo->entries[pos] = entry;
+	treeInfo->numOfKeys++;
+
+	//the greater keys moved, their hashed positions and their leaves are stale
+	entriesChanged(treeInfo);
+	markEntriesDirty(treeInfo, pos);
+
+	//keep the Bloom filter in sync, resize it once it holds more keys than it was sized for
+	if(treeInfo->bloom != NULL)
+	{
+		if(treeInfo->numOfKeys > treeInfo->bloom->capacity)
+			rebuildBloomFilter(treeInfo);
+		else
+			bloomAdd(treeInfo->bloom, &entry->value);
+	}
+
+	writeHeaderEntries(treeInfo);
+}
+
+/*
+ * This method is used to search for a key in the Tree
+ * Implemented for INT, FLOAT, STRING type
+ */
+RC findKey (BTreeHandle *tree, Value *key, RID *result)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	BTree *entry;
+
+	switch(treeInfo->engine)
+	{
+	case IE_ART:
+		return findKeyART(treeInfo, key, result);
+	case IE_HASH:
+		return findKeyHash(treeInfo, key, result);
+	case IE_FROZEN:
+		return findKeyFrozen(treeInfo, key, result);
+	default:
+		break;
+	}
+
+	entry = lookupEntry(treeInfo, key);
+	if(entry == NULL)
+	{
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	result->page = entry->rid.page;
+	result->slot = entry->rid.slot;
+	return RC_OK;
+}
+
+// order statistics
+/*
+ * This function counts the keys between low and high (both inclusive),
+ * a NULL bound leaves that side of the range open.
+ * Both ends are found with a search (through the learned index if there is one),
+ * no entry in between is visited
+ */
+RC countKeyRange (BTreeHandle *tree, Value *low, Value *high, int *result)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "order statistics need the B+ tree engine");
+	}
+
+	flushMessageBuffer(treeInfo);
+
+	int found;
+	int first = (low == NULL) ? 0 : locateKey(treeInfo, low, &found);
+	int last = treeInfo->numOfKeys;
+
+	//keys are unique, so the range ends right after high if high is in the tree
+	if(high != NULL)
+	{
+		last = locateKey(treeInfo, high, &found);
+		last += found;
+	}
+
+	*result = (last > first) ? last - first : 0;
+	return RC_OK;
+}
+
+/*
+ * This function estimates the number of keys between low and high (both inclusive)
+ * from the key histogram, a NULL bound leaves that side open. Unlike countKeyRange
+ * it neither merges the write buffer nor searches the entries, so it costs a search
+ * over the bounds of at most BT_HISTOGRAM_BUCKETS buckets
+ */
+RC estimateRangeCount (BTreeHandle *tree, Value *low, Value *high, int *result)
+{
+	KeyHistogram *histogram = ((BTree*)(tree->mgmtData))->histogram;
+	double below, upTo;
+
+	if(histogram == NULL)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "range estimates need the B+ tree engine");
+	}
+
+	if(histogram->numOfBuckets == 0)
+	{
+		*result = 0;
+		return RC_OK;
+	}
+
+	below = (low == NULL) ? 0 : histogramKeysBelow(histogram, low, FALSE);
+	upTo = (high == NULL) ? histogram->numOfKeys : histogramKeysBelow(histogram, high, TRUE);
+
+	*result = (upTo > below) ? (int)(upTo - below + 0.5) : 0;
+	return RC_OK;
+}
+
+/*
+ * This function returns the rank of a key i.e. the number of keys smaller than it,
+ * the key itself does not have to be in the tree
+ */
+RC getKeyRank (BTreeHandle *tree, Value *key, int *result)
+{
+	int found;
+
+	if(((BTree*)(tree->mgmtData))->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "order statistics need the B+ tree engine");
+	}
+
+	flushMessageBuffer((BTree*)(tree->mgmtData));
+
+	*result = locateKey((BTree*)(tree->mgmtData), key, &found);
+	return RC_OK;
+}
+
+/*
+ * This function returns a copy of the key with the given rank (0 is the smallest key),
+ * the caller frees it with freeVal. getKeyAtRank(tree, n/2, ...) gives the median
+ */
+RC getKeyAtRank (BTreeHandle *tree, int rank, Value **result)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "order statistics need the B+ tree engine");
+	}
+
+	flushMessageBuffer(treeInfo);
+
+	if(rank < 0 || rank >= treeInfo->numOfKeys)
+	{
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	*result = (Value*)malloc(sizeof(Value));
+	copyValue(*result, &treeInfo->entries[rank]->value);
+	return RC_OK;
+}
+
+/*
+ * This function is used to insert Keys into the B+ Tree
+ * The entries are kept in key order, so the position of the new key
+ * is found with a binary search.
+ * We also check whether the Key already exists,
+ * if yes we return already exists
+ */
+RC insertKey (BTreeHandle *tree, Value *key, RID rid)
+{
+	return insertKeyWithPayload(tree, key, rid, NULL);
+}
+
+/*
+ * This function is used to insert a Key together with the values of the
+ * included columns of a covering index, payload may be NULL
+ * when the entry has no included values
+ */
+RC insertKeyWithPayload (BTreeHandle *tree, Value *key, RID rid, Value **payload)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	int found, i, pos, pending;
+
+	//the included values must match the datatypes of the index
+	for(i = 0;payload != NULL && i<treeInfo->numOfIncluded;i++)
+	{
+		if(payload[i]->dt != treeInfo->includedTypes[i])
+			return RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE;
+	}
+
+	switch(treeInfo->engine)
+	{
+	case IE_ART:
+		return insertKeyART(treeInfo, key, rid, payload);
+	case IE_HASH:
+		return insertKeyHash(treeInfo, key, rid);
+	case IE_FROZEN:
+		THROW(RC_IM_INDEX_READ_ONLY, "a frozen index cannot be changed");
+	default:
+		break;
+	}
+
+	//a pending message of the key is newer than the entries
+	pending = findPendingMessage(treeInfo->buffer, key);
+	if(pending >= 0)
+		found = (treeInfo->buffer->messages[pending].type == BT_MSG_INSERT);
+	else
+		pos = searchKeyPosition(treeInfo, key, &found);
+
+	if(found)	//key already exists
+	{
+		return RC_IM_KEY_ALREADY_EXISTS;
+	}
+
+	//in write buffering mode the insert only becomes a message
+	if(treeInfo->buffer != NULL)
+	{
+		if(treeInfo->bloom != NULL)
+			bloomAdd(treeInfo->bloom, key);
+		bufferMessage(treeInfo, BT_MSG_INSERT, createEntry(key, rid, payload, treeInfo->numOfIncluded));
+		updateKeyHistogram(treeInfo, key, 1);
+		return RC_OK;
+	}
+
+	insertEntryAt(treeInfo, pos, createEntry(key, rid, payload, treeInfo->numOfIncluded));
+	updateKeyHistogram(treeInfo, key, 1);
+	return RC_OK;
+}
+
+/*
+ * This function is used to insert a batch of n Keys into the B+ Tree
+ * The batch is sorted first and then merged with the entries of the tree
+ * in a single left to right pass. The leaves from the one of the smallest
+ * batch key on are then written in another pass, every leaf page is pinned
+ * and marked dirty once and the header page once for the whole batch.
+ * Keys that already exist (in the tree or twice in the batch) are skipped,
+ * the remaining keys are inserted and RC_IM_KEY_ALREADY_EXISTS is returned
+ */
+RC insertKeys (BTreeHandle *tree, Value **keys, RID *rids, int n)
+{
+	return insertKeysWithPayload(tree, keys, rids, NULL, n);
+}
+
+/*
+ * This function inserts a batch of n Keys like insertKeys together with the values
+ * of the included columns of a covering index, payloads[i] holds the values of keys[i].
+ * payloads may be NULL when the entries have no included values
+ */
+RC insertKeysWithPayload (BTreeHandle *tree, Value **keys, RID *rids, Value ***payloads, int n)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	int i, j, k, skipped = 0;
+
+	if(n <= 0)
+		return RC_OK;
+
+	//the included values must match the datatypes of the index, checked before anything is inserted
+	for(i = 0;payloads != NULL && i<n;i++)
+	{
+		for(j = 0;payloads[i] != NULL && j<treeInfo->numOfIncluded;j++)
+		{
+			if(payloads[i][j]->dt != treeInfo->includedTypes[j])
+				return RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE;
+		}
+	}
+
+	//the other engines insert the keys one by one
+	if(treeInfo->engine != IE_BTREE)
+	{
+		for(i = 0;i<n;i++)
+		{
+			RC rc = insertKeyWithPayload(tree, keys[i], rids[i], (payloads != NULL) ? payloads[i] : NULL);
+
+			if(rc == RC_IM_KEY_ALREADY_EXISTS)
+				skipped++;
+			else if(rc != RC_OK)
+				return rc;
+		}
+		return (skipped > 0) ? RC_IM_KEY_ALREADY_EXISTS : RC_OK;
+	}
+
+	flushMessageBuffer(treeInfo);
+
+	//sort the batch by key
+	BTreeBatchEntry *batch = (BTreeBatchEntry*)malloc(sizeof(BTreeBatchEntry) * n);
+	for(i = 0;i<n;i++)
+	{
+		batch[i].key = keys[i];
+		batch[i].rid = rids[i];
+		batch[i].payload = (payloads != NULL) ? payloads[i] : NULL;
+	}
+	qsort(batch, n, sizeof(BTreeBatchEntry), compareBatchEntries);
+
+	//merge the sorted batch with the sorted entries into a new array
+	int mergedSize = (treeInfo->allocatedKeys > treeInfo->numOfKeys + n) ? treeInfo->allocatedKeys : treeInfo->numOfKeys + n;
+	BTree **merged = (BTree**)malloc(sizeof(BTree*) * mergedSize);
+
+	i = 0; j = 0; k = 0;
+	while(j < n)
+	{
+		//copy the existing entries smaller than the next batch key
+		while(i < treeInfo->numOfKeys && compareKeys(&treeInfo->entries[i]->value, batch[j].key) < 0)
+			merged[k++] = treeInfo->entries[i++];
+
+		//the entries in front of the smallest batch key keep their leaves
+		if(j == 0)
+			markEntriesDirty(treeInfo, k);
+
+		if((i < treeInfo->numOfKeys && compareKeys(&treeInfo->entries[i]->value, batch[j].key) == 0)
+				|| (k > 0 && compareKeys(&merged[k - 1]->value, batch[j].key) == 0))
+		{
+			skipped++;
+		}
+		else
+		{
+			merged[k++] = createEntry(batch[j].key, batch[j].rid, batch[j].payload, treeInfo->numOfIncluded);
+		}
+		j++;
+	}
+	while(i < treeInfo->numOfKeys)
+		merged[k++] = treeInfo->entries[i++];
+
+	free(batch);
+	replaceEntries(treeInfo, merged, k, mergedSize);
+	entriesChanged(treeInfo);
+
+	//a bulk load rebuilds the Bloom filter for the new number of keys and takes the histogram again
+	if(treeInfo->bloom != NULL)
+		rebuildBloomFilter(treeInfo);
+	if(treeInfo->histogram != NULL)
+		buildKeyHistogram(treeInfo);
+
+	//the merged entries are cut into leaves in one pass, from the leaf of the smallest batch key on
+	writeEntries(treeInfo);
+	writeHeaderEntries(treeInfo);
+
+	return (skipped > 0) ? RC_IM_KEY_ALREADY_EXISTS : RC_OK;
+}
+
+/*
+ * This function is used to enable the Bloom filter of the index with the
+ * given number of bits per key, or to disable it when bitsPerKey is 0.
+ * The filter is built from the current entries, maintained by insertKey,
+ * rebuilt by insertKeys and stored in the index pages when the tree is closed.
+ * findKey consults it first, so most absent keys are rejected without a search
+ */
+RC setBloomFilter (BTreeHandle *tree, int bitsPerKey)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "the Bloom filter needs the B+ tree engine");
+	}
+
+	flushMessageBuffer(treeInfo);
+	freeBloomFilter(treeInfo->bloom);
+	treeInfo->bloom = NULL;
+
+	if(bitsPerKey > 0)
+	{
+		treeInfo->bloom = createBloomFilter(bitsPerKey, 0);
+		rebuildBloomFilter(treeInfo);
+	}
+
+	writeBloomFilter(treeInfo);
+	return RC_OK;
+}
+
+/*
+ * This function switches the Eytzinger layout of an index on or off. The keys are copied
+ * in breadth first order, so findKey, countKeyRange and getKeyRank walk down a tree stored
+ * level by level, with a branch-free step for numeric keys and the next levels prefetched.
+ * It is meant for an index that is built and then only read: a write makes the layout
+ * stale and it is rebuilt only after numOfKeys / 16 lookups
+ */
+RC setEytzingerLayout (BTreeHandle *tree, bool enabled)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "the Eytzinger layout needs the B+ tree engine");
+	}
+
+	flushMessageBuffer(treeInfo);
+	freeEytzingerLayout(treeInfo);
+
+	if(enabled)
+	{
+		treeInfo->eytzinger = (EytzingerLayout*)calloc(1, sizeof(EytzingerLayout));
+		buildEytzingerLayout(treeInfo);
+	}
+	return RC_OK;
+}
+
+/*
+ * This function switches the interpolation search of a DT_INT index on or off, it is on
+ * after openBtree. While it is on, findKey, countKeyRange and getKeyRank use it whenever
+ * a sample of the keys is close to uniform and binary search otherwise.
+ * A learned index takes precedence over it
+ */
+RC setInterpolationSearch (BTreeHandle *tree, bool enabled)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "interpolation search needs the B+ tree engine");
+	}
+	if(tree->keyType != DT_INT)
+	{
+		THROW(RC_IM_KEY_TYPE_NOT_SUPPORTED, "interpolation search needs DT_INT keys");
+	}
+
+	flushMessageBuffer(treeInfo);
+	free(treeInfo->interpolation);
+	treeInfo->interpolation = NULL;
+
+	if(enabled)
+	{
+		treeInfo->interpolation = (InterpolationSearch*)calloc(1, sizeof(InterpolationSearch));
+		treeInfo->interpolation->uniform = sampleUniformKeys(treeInfo);
+		treeInfo->interpolation->valid = TRUE;
+	}
+	return RC_OK;
+}
+
+/*
+ * This function builds a learned index over the DT_INT keys of the index,
+ * piecewise linear models that predict the position of a key at most maxError
+ * entries away, or drops it when maxError is 0. findKey, countKeyRange and
+ * getKeyRank then search only around the predicted position. The model takes
+ * one segment per run of keys that fits a line, instead of inner nodes per N keys.
+ * Writes make it stale, it is rebuilt once enough lookups were made after them
+ */
+RC setLearnedIndex (BTreeHandle *tree, int maxError)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "the learned index needs the B+ tree engine");
+	}
+	if(tree->keyType != DT_INT)
+	{
+		THROW(RC_IM_KEY_TYPE_NOT_SUPPORTED, "the learned index needs DT_INT keys");
+	}
+
+	flushMessageBuffer(treeInfo);
+	freeLearnedIndex(treeInfo);
+
+	if(maxError > 0)
+	{
+		treeInfo->learned = (LearnedIndex*)calloc(1, sizeof(LearnedIndex));
+		treeInfo->learned->maxError = maxError;
+		buildLearnedIndex(treeInfo);
+	}
+	return RC_OK;
+}
+
+/*
+ * This function switches the index to write buffering mode:
+ * inserts and deletes are kept as messages in a buffer of the given capacity
+ * and applied to the entries in one sorted merge when the buffer fills,
+ * instead of shifting the entries and writing the header for every key.
+ * findKey, insertKey and deleteKey look at the pending messages first.
+ * The buffer is kept sorted, so lookups search it with a binary search and
+ * scans read it together with the entries without merging it first.
+ * A capacity of 0 applies the pending messages and leaves the mode
+ */
+RC setWriteBuffer (BTreeHandle *tree, int capacity)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "write buffering needs the B+ tree engine");
+	}
+
+	freeMessageBuffer(treeInfo);
+
+	if(capacity > 0)
+	{
+		treeInfo->buffer = (MessageBuffer*)malloc(sizeof(MessageBuffer));
+		treeInfo->buffer->capacity = capacity;
+		treeInfo->buffer->count = 0;
+		treeInfo->buffer->messages = (BTreeMessage*)malloc(sizeof(BTreeMessage) * capacity);
+	}
+	return RC_OK;
+}
+
+/*
+ * This function is used to enable copy-on-write with snapshot scans, or to disable it.
+ * A scan opened in this mode pins the current version of the entries and reads
+ * only that version: inserts and deletes made while it runs copy the entries
+ * instead of changing them under the scan and publish the copy with a new
+ * version number in the header page. Removed entries and old arrays are freed
+ * once no scan reads them anymore. Scans that are already open keep their mode
+ */
+RC setCopyOnWrite (BTreeHandle *tree, bool enabled)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "snapshot scans need the B+ tree engine");
+	}
+
+	treeInfo->versions->enabled = enabled;
+	return RC_OK;
+}
+
+/*
+ * This function is used to defragment the entries of the index. After many random
+ * inserts the entries lie wherever they were allocated, so a range scan jumps
+ * all over the memory. The entries are copied in key order into one contiguous
+ * block and the entry array is repacked to BT_DEFRAG_FILL percent, leaving room
+ * for the next inserts. The copies are published like any other write, so scans
+ * reading a snapshot keep the old entries until they are closed
+ */
+RC defragmentBtree (BTreeHandle *tree)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	BTree **packed;
+	int i, capacity;
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "only the B+ tree engine keeps its entries in key order");
+	}
+
+	flushMessageBuffer(treeInfo);
+
+	capacity = (int)((long long)treeInfo->numOfKeys * 100 / BT_DEFRAG_FILL);
+	if(capacity < treeInfo->numOfKeys + 1)
+		capacity = treeInfo->numOfKeys + 1;
+	packed = packEntries(treeInfo->entries, treeInfo->numOfKeys, capacity);
+
+	//the old entries stay readable for the open snapshot scans
+	for(i = 0;i<treeInfo->numOfKeys;i++)
+		retireEntry(treeInfo, treeInfo->entries[i]);
+	replaceEntries(treeInfo, packed, treeInfo->numOfKeys, capacity);
+
+	//the positions stay, but the string keys of the Eytzinger layout were in the old entries
+	if(treeInfo->eytzinger != NULL)
+		treeInfo->eytzinger->valid = FALSE;
+
+	writeHeaderEntries(treeInfo);
+	return RC_OK;
+}
+
+/*
+ * This function merges the write buffer into the entries right away,
+ * a caller can run it when the index is idle so that inserts and deletes
+ * on the hot path only ever touch the in-memory buffer
+ */
+RC mergeWriteBuffer (BTreeHandle *tree)
+{
+	flushMessageBuffer((BTree*)(tree->mgmtData));
+	return RC_OK;
+}
+
+/*
+ * This function is used to Delete a Key from the Tree
+ * The greater keys are shifted left to keep the entries sorted
+ */
+RC deleteKey (BTreeHandle *tree, Value *key)
+{
+	BTree* treeInfo = (BTree*)(tree->mgmtData);
+	int found, pos, pending;
+	RID noRid = { -1, -1 };
 
-	//Pin the page to be accessed to get data
-	pinPage(treeInfo->bm,treeInfo->ph,1);
+	switch(treeInfo->engine)
+	{
+	case IE_ART:
+		return deleteKeyART(treeInfo, key);
+	case IE_HASH:
+		return deleteKeyHash(treeInfo, key);
+	case IE_FROZEN:
+		THROW(RC_IM_INDEX_READ_ONLY, "a frozen index cannot be changed");
+	default:
+		break;
+	}
 
-	//store the page data i.e. N value
-	treeInfo->maxNumOfKeysPerNode = *((int*)treeInfo->ph->data);
+	//a pending message of the key is newer than the entries
+	pending = findPendingMessage(treeInfo->buffer, key);
+	if(pending >= 0)
+		found = (treeInfo->buffer->messages[pending].type == BT_MSG_INSERT);
+	else
+		pos = searchKeyPosition(treeInfo, key, &found);
 
-	//Node Counter to count number of Nodes
-	treeInfo->nodeCounter=0;
+	if(!found)
+	{
+		return RC_IM_KEY_NOT_FOUND;
+	}
 
-	//store the entire data into the management data for the Tree Handle
-	BTreeHandle *temp = (BTreeHandle*)malloc(sizeof(BTreeHandle));
-	temp->mgmtData = treeInfo;
-	*tree = temp;
+	//in write buffering mode the delete only becomes a message
+	if(treeInfo->buffer != NULL)
+	{
+		bufferMessage(treeInfo, BT_MSG_DELETE, createEntry(key, noRid, NULL, 0));
+		updateKeyHistogram(treeInfo, key, -1);
+		return RC_OK;
+	}
 
-	//unpin the page after read operation is performed
-	unpinPage(treeInfo->bm,treeInfo->ph);
+	detachCurrentVersion(treeInfo, TRUE);
+	releaseOverflowPages(treeInfo, treeInfo->entries[pos]);
+	retireEntry(treeInfo, treeInfo->entries[pos]);
+	memmove(&treeInfo->entries[pos], &treeInfo->entries[pos + 1], sizeof(BTree*) * (treeInfo->numOfKeys - pos - 1));
+	treeInfo->numOfKeys--;
+	entriesChanged(treeInfo);
+	markEntriesDirty(treeInfo, pos);
+	updateKeyHistogram(treeInfo, key, -1);
 
-	//close the page file
-	closePageFile(&fh);
+	writeHeaderEntries(treeInfo);
 
 	return RC_OK;
 }
 
 /*
- * Used to close the B-Tree
+ * Create a scan handle with its cursors at the given positions,
+ * atEnd places the cursor of the ART engine after the last key
  */
-RC closeBtree (BTreeHandle *tree)
+static BT_ScanHandle *createScanHandle (BTreeHandle *tree, int cursor, int deltaCursor, int atEnd)
 {
-	//free the memory allocated for the tree
-	free(tree);
-	return RC_OK;
+	BT_ScanHandle *handle = (BT_ScanHandle*)malloc(sizeof(BT_ScanHandle));
+	BT_ScanMgmt *scanMgmt = (BT_ScanMgmt*)malloc(sizeof(BT_ScanMgmt));
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+
+	scanMgmt->cursor = cursor;
+	scanMgmt->deltaCursor = deltaCursor;
+	artCursorInit(&scanMgmt->artCursor, treeInfo->art, atEnd);
+	scanMgmt->frozenEntry.payload = NULL;
+	scanMgmt->frozenEntry.numOfIncluded = 0;
+	scanMgmt->snapshot = NULL;
+	scanMgmt->prefetchDirection = 0;
+	handle->tree = tree;
+	handle->mgmtData = scanMgmt;
+	return handle;
 }
 
 /*
- * This function is used to delete the tree
- * i.e. destroy the page file created and free all memory
+ * Pin the current version of the entries for a scan in copy-on-write mode,
+ * the write buffer is merged first so that the snapshot holds every key
  */
-RC deleteBtree (char *idxId)
+static void pinScanSnapshot (BTree *treeInfo, BT_ScanMgmt *scanMgmt)
 {
-	destroyPageFile(idxId);
-	numOfKeys = 0;
-	scanNextEntry = 0;
-	return RC_OK;
+	if(treeInfo->versions == NULL || !treeInfo->versions->enabled)
+		return;
+
+	flushMessageBuffer(treeInfo);
+	scanMgmt->snapshot = pinSnapshot(treeInfo);
 }
 
-// access information about a b-tree
 /*
- * Get the total Number of Nodes in the B+Tree formed
+ * Move the prefetch window of a scan whose next entry is at pos in direction
+ * (1 forward, -1 backward). The window is refilled once the scan used up half of it
+ * and doubles with every refill up to maxWindow, so a long scan runs far ahead
+ * while one that stops after a few entries prefetches little. Turning around
+ * starts over with a small window.
+ * returns the number of entries to prefetch from *from on, in ascending order
  */
-RC getNumNodes (BTreeHandle *tree, int *result)
+static int advancePrefetchWindow (BT_ScanMgmt *scanMgmt, int pos, int direction, int numOfEntries, int maxWindow, int *from)
 {
-	//if the node is on the same page i.e. thier RID's are same, then they are on same node
-	//so total number of keys inserted MINUS same nodes will give us the final result
+	int start, stop;
 
-	int headNode, compareNode, samePageEntry;
+	if(direction != scanMgmt->prefetchDirection)
+	{
+		scanMgmt->prefetchDirection = direction;
+		scanMgmt->prefetchWindow = BT_PREFETCH_MIN;
+		scanMgmt->prefetchEnd = (direction > 0) ? pos : pos + 1;
+	}
 
-	for(headNode=1;headNode<numOfKeys;headNode++)
+	if(direction > 0)
 	{
-		for(compareNode=headNode-1;compareNode>=0;compareNode--)
-		{
-			if(AllocBTree[headNode]->rid.page==AllocBTree[compareNode]->rid.page)
-			{
-				samePageEntry++;
-			}
-		}
+		if(scanMgmt->prefetchEnd - pos > scanMgmt->prefetchWindow / 2)
+			return 0;
+		start = (scanMgmt->prefetchEnd > pos) ? scanMgmt->prefetchEnd : pos;
+		stop = (pos + scanMgmt->prefetchWindow < numOfEntries) ? pos + scanMgmt->prefetchWindow : numOfEntries;
+		if(stop > start)
+			scanMgmt->prefetchEnd = stop;
+	}
+	else
+	{
+		if(pos + 1 - scanMgmt->prefetchEnd > scanMgmt->prefetchWindow / 2)
+			return 0;
+		stop = (scanMgmt->prefetchEnd < pos + 1) ? scanMgmt->prefetchEnd : pos + 1;
+		start = (pos + 1 - scanMgmt->prefetchWindow > 0) ? pos + 1 - scanMgmt->prefetchWindow : 0;
+		if(stop > start)
+			scanMgmt->prefetchEnd = start;
 	}
 
-	//calculate the NumOfNodes
-	int numOfNodes = numOfKeys - samePageEntry;
-	*result = numOfNodes;
+	if(scanMgmt->prefetchWindow < maxWindow)
+		scanMgmt->prefetchWindow = (scanMgmt->prefetchWindow * 2 < maxWindow) ? scanMgmt->prefetchWindow * 2 : maxWindow;
 
-	return RC_OK;
+	*from = start;
+	return (stop > start) ? stop - start : 0;
 }
 
 /*
- * Total number of entries in the B+ -Tree i.e. the Number of Keys
+ * Prefetch the entries ahead of a scan of the sorted entries, they were
+ * allocated one by one, so without the hint every entry can be a cache miss
  */
-RC getNumEntries (BTreeHandle *tree, int *result)
+static void prefetchEntries (BT_ScanMgmt *scanMgmt, BTree **entries, int pos, int direction, int numOfEntries)
 {
-	//as we have stored the values for every insert we can utilize that directly here
-	*result = numOfKeys;
-	return RC_OK;
+	int from, i;
+	int count = advancePrefetchWindow(scanMgmt, pos, direction, numOfEntries, BT_PREFETCH_MAX, &from);
+
+	for(i = from;i<from + count;i++)
+		BT_PREFETCH(entries[i]);
 }
 
 /*
- * Gets the type of Key in the tree inserted and stores it in the result
+ * Ask the kernel to read the pages of a frozen export ahead of a scan,
+ * the reads then overlap with the work of the scan
  */
-RC getKeyType (BTreeHandle *tree, DataType *result)
+static void readAheadFrozen (FrozenIndex *frozen, BT_ScanMgmt *scanMgmt, int pos, int direction)
 {
-	int i;
+	int from;
+	int maxWindow = BT_PREFETCH_FROZEN_BYTES / frozen->entrySize;
+	int count = advancePrefetchWindow(scanMgmt, pos, direction, frozen->numOfKeys, maxWindow, &from);
 
-	for(i=0;i<numOfKeys;i++)
-	{
-		result[i] = tree->keyType;
-	}
-	return RC_OK;
+	if(count > 0)
+		frozenWillNeed(frozen, from, count);
 }
 
-// index access
 /*
- * This method is used to search for a key in the Tree
- * Implemented for INT, FLOAT, STRING type
+ * Move the scan one entry forward over the merged view of the entries and
+ * the write buffer: a pending message hides the entry with the same key
+ * and a pending delete hides the key altogether.
+ * returns the entry or NULL at the end of the tree
  */
-RC findKey (BTreeHandle *tree, Value *key, RID *result)
+static BTree *scanForward (BTree *treeInfo, BT_ScanMgmt *scanMgmt)
 {
+	int numOfMessages = (treeInfo->buffer == NULL) ? 0 : treeInfo->buffer->count;
+
+	//a snapshot scan only reads the version it pinned
+	if(scanMgmt->snapshot != NULL)
+	{
+		if(scanMgmt->cursor >= scanMgmt->snapshot->numOfKeys)
+			return NULL;
+		prefetchEntries(scanMgmt, scanMgmt->snapshot->entries, scanMgmt->cursor, 1, scanMgmt->snapshot->numOfKeys);
+		return scanMgmt->snapshot->entries[scanMgmt->cursor++];
+	}
 
-	int i=0;
-	int flagFound=0;
+	switch(treeInfo->engine)
+	{
+	case IE_ART:
+		return (BTree*)artCursorNext(&scanMgmt->artCursor);
+	case IE_FROZEN:
+		if(scanMgmt->cursor >= treeInfo->frozen->numOfKeys)
+			return NULL;
+		readAheadFrozen(treeInfo->frozen, scanMgmt, scanMgmt->cursor, 1);
+		frozenEntry(treeInfo->frozen, scanMgmt->cursor++, &scanMgmt->frozenEntry.value, &scanMgmt->frozenEntry.rid);
+		return &scanMgmt->frozenEntry;
+	default:
+		break;
+	}
+
+	if(scanMgmt->cursor < treeInfo->numOfKeys)
+		prefetchEntries(scanMgmt, treeInfo->entries, scanMgmt->cursor, 1, treeInfo->numOfKeys);
 
-	for(i = 0;i<numOfKeys;i++)
+	while(scanMgmt->cursor < treeInfo->numOfKeys || scanMgmt->deltaCursor < numOfMessages)
 	{
+		BTree *entry = (scanMgmt->cursor < treeInfo->numOfKeys) ? treeInfo->entries[scanMgmt->cursor] : NULL;
+		BTreeMessage *message = (scanMgmt->deltaCursor < numOfMessages) ? &treeInfo->buffer->messages[scanMgmt->deltaCursor] : NULL;
+		int cmp = (entry == NULL) ? 1 : (message == NULL) ? -1 : compareKeys(&entry->value, &message->entry->value);
 
-		switch(key->dt)
+		if(cmp < 0)
 		{
-		case DT_INT:
-			if(AllocBTree[i]->value.dt==key->dt && AllocBTree[i]->value.v.intV==key->v.intV)
-				flagFound=1;
-			break;
-		case DT_FLOAT:
-			if(AllocBTree[i]->value.dt==key->dt && AllocBTree[i]->value.v.floatV==key->v.floatV)
-				flagFound=1;
-			break;
-		case DT_STRING:
-			if(AllocBTree[i]->value.dt==key->dt && AllocBTree[i]->value.v.stringV==key->v.stringV)
-				flagFound=1;
-			break;
-		default:
-			return RC_RM_NO_PRINT_FOR_DATATYPE;
+			scanMgmt->cursor++;
+			return entry;
 		}
 
-		if(flagFound)	//if key found
+		if(cmp == 0)
+			scanMgmt->cursor++;
+		scanMgmt->deltaCursor++;
+		if(message->type == BT_MSG_INSERT)
+			return message->entry;
+	}
+	return NULL;
+}
+
+/*
+ * Move the scan one entry backward over the merged view of the entries
+ * and the write buffer, returns the entry or NULL before the first key
+ */
+static BTree *scanBackward (BTree *treeInfo, BT_ScanMgmt *scanMgmt)
+{
+	int numOfMessages = (treeInfo->buffer == NULL) ? 0 : treeInfo->buffer->count;
+
+	if(scanMgmt->snapshot != NULL)
+	{
+		if(scanMgmt->cursor <= 0)
+			return NULL;
+		prefetchEntries(scanMgmt, scanMgmt->snapshot->entries, scanMgmt->cursor - 1, -1, scanMgmt->snapshot->numOfKeys);
+		return scanMgmt->snapshot->entries[--scanMgmt->cursor];
+	}
+
+	switch(treeInfo->engine)
+	{
+	case IE_ART:
+		return (BTree*)artCursorPrev(&scanMgmt->artCursor);
+	case IE_FROZEN:
+		if(scanMgmt->cursor <= 0)
+			return NULL;
+		readAheadFrozen(treeInfo->frozen, scanMgmt, scanMgmt->cursor - 1, -1);
+		frozenEntry(treeInfo->frozen, --scanMgmt->cursor, &scanMgmt->frozenEntry.value, &scanMgmt->frozenEntry.rid);
+		return &scanMgmt->frozenEntry;
+	default:
+		break;
+	}
+
+	//the tree may have shrunk since the scan was opened
+	if(scanMgmt->cursor > treeInfo->numOfKeys)
+		scanMgmt->cursor = treeInfo->numOfKeys;
+	if(scanMgmt->deltaCursor > numOfMessages)
+		scanMgmt->deltaCursor = numOfMessages;
+
+	if(scanMgmt->cursor > 0)
+		prefetchEntries(scanMgmt, treeInfo->entries, scanMgmt->cursor - 1, -1, treeInfo->numOfKeys);
+
+	while(scanMgmt->cursor > 0 || scanMgmt->deltaCursor > 0)
+	{
+		BTree *entry = (scanMgmt->cursor > 0) ? treeInfo->entries[scanMgmt->cursor - 1] : NULL;
+		BTreeMessage *message = (scanMgmt->deltaCursor > 0) ? &treeInfo->buffer->messages[scanMgmt->deltaCursor - 1] : NULL;
+		int cmp = (entry == NULL) ? -1 : (message == NULL) ? 1 : compareKeys(&entry->value, &message->entry->value);
+
+		if(cmp > 0)
 		{
-			result->page = AllocBTree[i]->rid.page;
-			result->slot = AllocBTree[i]->rid.slot;
-			return RC_OK;
+			scanMgmt->cursor--;
+			return entry;
 		}
 
+		if(cmp == 0)
+			scanMgmt->cursor--;
+		scanMgmt->deltaCursor--;
+		if(message->type == BT_MSG_INSERT)
+			return message->entry;
 	}
-	if(i==numOfKeys)
+	return NULL;
+}
+
+/*
+ * Create a tree ready for Scan,
+ * the Keys are already sorted, so the Scanner starts before the first one
+ */
+RC openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle)
+{
+	//hashed keys have no order to scan in
+	if(((BTree*)(tree->mgmtData))->engine == IE_HASH)
 	{
-		return RC_IM_KEY_NOT_FOUND;
+		*handle = NULL;
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "the hash engine only supports point lookups");
 	}
+
+	*handle = createScanHandle(tree, 0, 0, 0);
+	pinScanSnapshot((BTree*)(tree->mgmtData), (BT_ScanMgmt*)((*handle)->mgmtData));
+	return RC_OK;
 }
 
 /*
- * This function is used to insert Keys into the B+ Tree
- * We check if it is the first Node to be inserted,
- * if yes we insert it and increment the num of Keys
- * We also check whether the Key already exists,
- * if yes we return already exists
- * Mark the Node full when the node has "N" keys
+ * Create a tree ready for a descending Scan,
+ * the Scanner starts after the last Key and prevEntry walks towards the first one.
+ * ORDER BY key DESC LIMIT N only reads the N greatest entries
  */
-RC insertKey (BTreeHandle *tree, Value *key, RID rid)
+RC openTreeScanReverse (BTreeHandle *tree, BT_ScanHandle **handle)
 {
-	//allocate memory in the node for the Key to be inserted
 	BTree *treeInfo = (BTree*)(tree->mgmtData);
-	AllocBTree[numOfKeys] = (BTree*)malloc(sizeof(BTree));
+	BT_ScanMgmt *scanMgmt;
+	int numOfMessages = (treeInfo->buffer == NULL) ? 0 : treeInfo->buffer->count;
 
-	//flag to check whether Key already exists
-	int flagFound=0;
-
-	//i.e. first key to be inserted
-	if(numOfKeys==0)
+	if(treeInfo->engine == IE_HASH)
 	{
-		pinPage(treeInfo->bm,treeInfo->ph,numOfKeys);
-		markDirty(treeInfo->bm,treeInfo->ph);
-		treeInfo->ph->data = "NotFull";
-
-		switch(key->dt)
-		{
+		*handle = NULL;
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "the hash engine only supports point lookups");
+	}
 
-		case DT_INT:
-			AllocBTree[numOfKeys]->value.dt = key->dt;
-			AllocBTree[numOfKeys]->value.v.intV = key->v.intV;
-			break;
+	if(treeInfo->engine == IE_FROZEN)
+	{
+		*handle = createScanHandle(tree, treeInfo->frozen->numOfKeys, 0, 1);
+		return RC_OK;
+	}
 
-		case DT_FLOAT:
-			AllocBTree[numOfKeys]->value.dt = key->dt;
-			AllocBTree[numOfKeys]->value.v.floatV = key->v.floatV;
-			break;
+	*handle = createScanHandle(tree, treeInfo->numOfKeys, numOfMessages, 1);
 
-		case DT_STRING:
-			AllocBTree[numOfKeys]->value.dt = key->dt;
-			AllocBTree[numOfKeys]->value.v.intV = key->v.intV;
-			break;
-		default:
-			return RC_RM_NO_PRINT_FOR_DATATYPE;
-		}
-		AllocBTree[numOfKeys]->rid.page = rid.page;
-		AllocBTree[numOfKeys]->rid.slot = rid.slot;
+	//a snapshot scan starts after the last key of its version
+	scanMgmt = (BT_ScanMgmt*)((*handle)->mgmtData);
+	pinScanSnapshot(treeInfo, scanMgmt);
+	if(scanMgmt->snapshot != NULL)
+		scanMgmt->cursor = scanMgmt->snapshot->numOfKeys;
+	return RC_OK;
+}
 
-		numOfKeys++;
-		unpinPage(treeInfo->bm,treeInfo->ph);
+/*
+ * read the entry from the Tree until the No more entires are left in the tree and
+ * store the page and slot info in result
+ */
+RC nextEntry (BT_ScanHandle *handle, RID *result)
+{
+	BTree *entry = scanForward((BTree*)(handle->tree->mgmtData), (BT_ScanMgmt*)(handle->mgmtData));
 
+	if(entry != NULL)
+	{
+		result->page = entry->rid.page;
+		result->slot = entry->rid.slot;
 		return RC_OK;
-
 	}
 	else
 	{
-		//find if the Key already Exists
-		int i=0;
-		for(i=0;i<numOfKeys;i++)
-		{
-			switch(key->dt)
-			{
-
-			case DT_INT:
-				if(AllocBTree[i]->value.dt==key->dt && AllocBTree[i]->value.v.intV==key->v.intV)
-					flagFound=1;
-				break;
-			case DT_FLOAT:
-				if(AllocBTree[i]->value.dt==key->dt && AllocBTree[i]->value.v.floatV==key->v.floatV)
-					flagFound=1;
-				break;
-			case DT_STRING:
-				if(AllocBTree[i]->value.dt==key->dt && AllocBTree[i]->value.v.stringV==key->v.stringV)
-					flagFound=1;
-				break;
-			default:
-				return RC_RM_NO_PRINT_FOR_DATATYPE;
-			}
-		}
+		return RC_IM_NO_MORE_ENTRIES;
+	}
 
-		if(flagFound)	//key already exists
-		{
-			return RC_IM_KEY_ALREADY_EXISTS;
-		}
-		else	//insert the new Key
-		{
-			pinPage(treeInfo->bm,treeInfo->ph,treeInfo->nodeCounter);
-			markDirty(treeInfo->bm,treeInfo->ph);
+}
 
-			if(!(strcmp(treeInfo->ph->data,"NodeFull")))	//if Node is Full //insert into other page
-			{
-				treeInfo->nodeCounter++;
-				unpinPage(treeInfo->bm,treeInfo->ph);
-				pinPage(treeInfo->bm,treeInfo->ph,treeInfo->nodeCounter);
-
-				switch(key->dt)
-				{
-				case DT_INT:
-					AllocBTree[numOfKeys]->value.dt = key->dt;
-					AllocBTree[numOfKeys]->value.v.intV = key->v.intV;
-					break;
-
-				case DT_FLOAT:
-					AllocBTree[numOfKeys]->value.dt = key->dt;
-					AllocBTree[numOfKeys]->value.v.floatV = key->v.floatV;
-					break;
-
-				case DT_STRING:
-					AllocBTree[numOfKeys]->value.dt = key->dt;
-					AllocBTree[numOfKeys]->value.v.intV = key->v.intV;
-					break;
-
-				default:
-					return RC_RM_NO_PRINT_FOR_DATATYPE;
-				}
-
-				//set the Rid & Value
-				AllocBTree[numOfKeys]->rid.page = rid.page;
-				AllocBTree[numOfKeys]->rid.slot = rid.slot;
-
-				//increment the Keys and mark the new node as not full
-				treeInfo->ph->data="NotFull";
-				numOfKeys++;
-				unpinPage(treeInfo->bm,treeInfo->ph);
-			}
-			else
-			{
-				switch(key->dt)
-				{
-				case DT_INT:
-					AllocBTree[numOfKeys]->value.dt = key->dt;
-					AllocBTree[numOfKeys]->value.v.intV = key->v.intV;
-					break;
-
-				case DT_FLOAT:
-					AllocBTree[numOfKeys]->value.dt = key->dt;
-					AllocBTree[numOfKeys]->value.v.floatV = key->v.floatV;
-					break;
-
-				case DT_STRING:
-					AllocBTree[numOfKeys]->value.dt = key->dt;
-					AllocBTree[numOfKeys]->value.v.intV = key->v.intV;
-					break;
-
-				default:
-					return RC_RM_NO_PRINT_FOR_DATATYPE;
-				}
-
-				//set the Rid & Value
-				AllocBTree[numOfKeys]->rid.page = rid.page;
-				AllocBTree[numOfKeys]->rid.slot = rid.slot;
-
-				//increment the Keys and Make the Node Full as N values are inserted
-				treeInfo->ph->data="NodeFull";
-				numOfKeys++;
-				unpinPage(treeInfo->bm,treeInfo->ph);
+/*
+ * read the entry before the cursor of the Scan and move the cursor back,
+ * returns the RIDs in descending key order until the first entry was read
+ */
+RC prevEntry (BT_ScanHandle *handle, RID *result)
+{
+	BTree *entry = scanBackward((BTree*)(handle->tree->mgmtData), (BT_ScanMgmt*)(handle->mgmtData));
 
-			}
-			return RC_OK;
-		}
+	if(entry != NULL)
+	{
+		result->page = entry->rid.page;
+		result->slot = entry->rid.slot;
+		return RC_OK;
+	}
+	else
+	{
+		return RC_IM_NO_MORE_ENTRIES;
 	}
-	return RC_OK;
 }
 
 /*
- * This function is used to Delete a Key from the Tree
- * Marks the node as Not full after deletion of Key from the Node
+ * read the next entry like nextEntry, and also return a copy of its key
+ * and of its included column values, payload must have room for the number
+ * of included columns of the index. Values that were not stored are set to NULL,
+ * the caller frees the returned values with freeVal
  */
-RC deleteKey (BTreeHandle *tree, Value *key)
+RC nextEntryWithPayload (BT_ScanHandle *handle, Value **key, RID *result, Value **payload)
 {
-	//printf("Deleting B-Tree\n");
-
-	BTree* treeInfo = (BTree*)(tree->mgmtData);
+	BTree *treeInfo = (BTree*)(handle->tree->mgmtData);
+	BTree *entry = scanForward(treeInfo, (BT_ScanMgmt*)(handle->mgmtData));
+	int i;
 
-	int i=0;
-	int flagFound=0;
-	int deletedKeyIndex, nextKeyIndex;
-	for(i = 0;i<numOfKeys;i++)
+	if(entry == NULL)
 	{
+		return RC_IM_NO_MORE_ENTRIES;
+	}
 
-		switch(key->dt)
-		{
-		case DT_INT:
-			if(AllocBTree[i]->value.dt==key->dt && AllocBTree[i]->value.v.intV==key->v.intV)
-				flagFound=1;
-			break;
-		case DT_FLOAT:
-			if(AllocBTree[i]->value.dt==key->dt && AllocBTree[i]->value.v.floatV==key->v.floatV)
-				flagFound=1;
-			break;
-		case DT_STRING:
-			if(AllocBTree[i]->value.dt==key->dt && AllocBTree[i]->value.v.stringV==key->v.stringV)
-				flagFound=1;
-			break;
-		default:
-			return RC_RM_NO_PRINT_FOR_DATATYPE;
-		}
-
-		if(flagFound)	//if Key found
-		{
-			pinPage(treeInfo->bm,treeInfo->ph,(i/2));	//find the node page
-			treeInfo->ph->data = "NotFull";				//mark it not full node
+	result->page = entry->rid.page;
+	result->slot = entry->rid.slot;
 
-			markDirty(treeInfo->bm,treeInfo->ph);
-			unpinPage(treeInfo->bm,treeInfo->ph);
+	*key = (Value*)malloc(sizeof(Value));
+	copyValue(*key, &entry->value);
 
-			deletedKeyIndex=i;
-			nextKeyIndex = deletedKeyIndex+1;
-			//move the Keys and Nodes after deletion is done
-			int k;
-			for(k=deletedKeyIndex;k<numOfKeys && nextKeyIndex<numOfKeys;k++)
-			{
-				switch(AllocBTree[nextKeyIndex]->value.dt)
-				{
-				case DT_INT:
-					AllocBTree[k]->value.dt = AllocBTree[nextKeyIndex]->value.dt;
-					AllocBTree[k]->value.v.intV = AllocBTree[nextKeyIndex]->value.v.intV;
-					break;
-				case DT_FLOAT:
-					AllocBTree[k]->value.dt = AllocBTree[nextKeyIndex]->value.dt;
-					AllocBTree[k]->value.v.floatV = AllocBTree[nextKeyIndex]->value.v.floatV;
-					break;
-				case DT_STRING:
-					AllocBTree[k]->value.dt = AllocBTree[nextKeyIndex]->value.dt;
-					strcpy(AllocBTree[k]->value.v.stringV, AllocBTree[nextKeyIndex]->value.v.stringV);
-					break;
-				}
-
-				AllocBTree[k]->rid.page = AllocBTree[nextKeyIndex]->rid.page;
-				AllocBTree[k]->rid.slot = AllocBTree[nextKeyIndex]->rid.slot;
-				nextKeyIndex++;
-			}
-			numOfKeys--;
-			free(AllocBTree[k]);
-			return RC_OK;
+	for(i = 0;i<treeInfo->numOfIncluded;i++)
+	{
+		payload[i] = NULL;
+		if(i < entry->numOfIncluded)
+		{
+			payload[i] = (Value*)malloc(sizeof(Value));
+			copyValue(payload[i], entry->payload[i]);
 		}
-
-		if(i == numOfKeys)
-			return RC_IM_KEY_NOT_FOUND;
 	}
 
 	return RC_OK;
 }
 
 /*
- * Create a tree ready for Scan,
- * make all the Keys sorted for the Scanner to read them
+ * Close the Scan for Tree
  */
-RC openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle)
+RC closeTreeScan (BT_ScanHandle *handle)
+{
+	BT_ScanMgmt *scanMgmt = (BT_ScanMgmt*)(handle->mgmtData);
+
+	if(scanMgmt->snapshot != NULL)
+		releaseSnapshot((BTree*)(handle->tree->mgmtData), scanMgmt->snapshot);
+	artCursorClose(&scanMgmt->artCursor);
+	free(handle->mgmtData);
+	free(handle);
+	return RC_OK;
+}
+
+// key-value access
+/*
+ * This function stores a value of length bytes under a key, the value of a key
+ * already in the tree is replaced. Values up to BT_KV_INLINE_MAX bytes are stored
+ * in the entry itself, so kvGet returns them after the search of the key alone.
+ * Larger values are written to a chain of overflow pages in idxId.ovf
+ */
+RC kvPut (BTreeHandle *tree, Value *key, char *value, int length)
 {
-	int i=0,j, indexSmallKey;
-	Value tempValueSwap;
-	RID tempRidSwap;
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	BTree *entry;
+	RID noRid = { -1, -1 };
+	int found, pos, pending;
 
-	switch(AllocBTree[i]->value.dt)
+	if(treeInfo->engine != IE_BTREE)
 	{
-	case DT_INT:
-		for(i=0;i<numOfKeys-1;i++)
-		{
-			indexSmallKey = i;
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "key-value access needs the B+ tree engine");
+	}
 
-			//SORT
-			for(j=i+1;j<numOfKeys;j++)
-			{
-				if(AllocBTree[j]->value.v.intV < AllocBTree[indexSmallKey]->value.v.intV)
-				{
-					indexSmallKey = j;
-				}
-			}
-			tempValueSwap = AllocBTree[indexSmallKey]->value;
-			tempRidSwap = AllocBTree[indexSmallKey]->rid;
+	entry = createEntry(key, noRid, NULL, 0);
+	entry->kv = createKVValue(treeInfo, value, length);
+	if(entry->kv == NULL)
+	{
+		freeEntry(entry);
+		THROW(RC_WRITE_FAILED, "could not create the overflow file of the index");
+	}
 
-			AllocBTree[indexSmallKey]->value = AllocBTree[i]->value;
-			AllocBTree[indexSmallKey]->rid = AllocBTree[i]->rid;
+	//in write buffering mode the put becomes an insert message, the merge replaces the old value
+	if(treeInfo->buffer != NULL)
+	{
+		//only a new key is counted in the histogram
+		pending = findPendingMessage(treeInfo->buffer, key);
+		if(pending >= 0)
+			found = (treeInfo->buffer->messages[pending].type == BT_MSG_INSERT);
+		else
+			searchKeyPosition(treeInfo, key, &found);
 
-			AllocBTree[i]->value = tempValueSwap;
-			AllocBTree[i]->rid = tempRidSwap;
-		}
-		break;
+		if(treeInfo->bloom != NULL)
+			bloomAdd(treeInfo->bloom, key);
+		bufferMessage(treeInfo, BT_MSG_INSERT, entry);
+		if(!found)
+			updateKeyHistogram(treeInfo, key, 1);
+		return RC_OK;
+	}
 
-	case DT_FLOAT:
-		for(i=0;i<numOfKeys-1;i++)
-		{
-			indexSmallKey = i;
+	pos = searchKeyPosition(treeInfo, key, &found);
+	if(!found)
+	{
+		insertEntryAt(treeInfo, pos, entry);
+		updateKeyHistogram(treeInfo, key, 1);
+		return RC_OK;
+	}
 
-			for(j=i+1;j<numOfKeys;j++)
-			{
-				if(AllocBTree[j]->value.v.floatV < AllocBTree[indexSmallKey]->value.v.floatV)
-				{
-					indexSmallKey = j;
-				}
-			}
-			tempValueSwap = AllocBTree[indexSmallKey]->value;
-			tempRidSwap = AllocBTree[indexSmallKey]->rid;
+	//the new entry takes the place of the old one, on a copy of the entries if a scan reads them
+	detachCurrentVersion(treeInfo, TRUE);
+	releaseOverflowPages(treeInfo, treeInfo->entries[pos]);
+	retireEntry(treeInfo, treeInfo->entries[pos]);
+	treeInfo->entries[pos] = entry;
+	if(treeInfo->eytzinger != NULL)
+		treeInfo->eytzinger->valid = FALSE;
+	markEntriesDirty(treeInfo, pos);
+	writeHeaderEntries(treeInfo);
 
-			AllocBTree[indexSmallKey]->value = AllocBTree[i]->value;
-			AllocBTree[indexSmallKey]->rid = AllocBTree[i]->rid;
+	return RC_OK;
+}
 
-			AllocBTree[i]->value = tempValueSwap;
-			AllocBTree[i]->rid = tempRidSwap;
-		}
-		break;
+/*
+ * This function returns a copy of the value stored under a key and its length,
+ * the caller frees it. The copy has a terminating 0 behind the value
+ */
+RC kvGet (BTreeHandle *tree, Value *key, char **value, int *length)
+{
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
+	BTree *entry;
+
+	if(treeInfo->engine != IE_BTREE)
+	{
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "key-value access needs the B+ tree engine");
 	}
-	return RC_OK;
+
+	entry = lookupEntry(treeInfo, key);
+	if(entry == NULL)
+	{
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	return readKVValue(treeInfo, entry, value, length);
 }
 
 /*
- * read the entry from the Tree until the No more entires are left in the tree and
- * store the page and slot info in result
+ * This function deletes a key and its value, the overflow pages of the value are reused
  */
-RC nextEntry (BT_ScanHandle *handle, RID *result)
+RC kvDelete (BTreeHandle *tree, Value *key)
 {
-	if(scanNextEntry < numOfKeys)
+	if(((BTree*)(tree->mgmtData))->engine != IE_BTREE)
 	{
-		result->page = AllocBTree[scanNextEntry]->rid.page;
-		result->slot = AllocBTree[scanNextEntry]->rid.slot;
-		scanNextEntry++;
-		return RC_OK;
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "key-value access needs the B+ tree engine");
 	}
-	else
+
+	return deleteKey(tree, key);
+}
+
+/*
+ * This function opens a scan over the keys and values in key order,
+ * it is read with kvNext and closed with closeTreeScan
+ */
+RC kvScan (BTreeHandle *tree, BT_ScanHandle **handle)
+{
+	if(((BTree*)(tree->mgmtData))->engine != IE_BTREE)
 	{
-		return RC_IM_NO_MORE_ENTRIES;
+		THROW(RC_IM_NOT_SUPPORTED_BY_ENGINE, "key-value access needs the B+ tree engine");
 	}
 
+	return openTreeScan(tree, handle);
 }
 
 /*
- * Close the Scan for Tree
+ * This function returns copies of the next key and its value like kvGet,
+ * the caller frees the key with freeVal and the value with free
  */
-RC closeTreeScan (BT_ScanHandle *handle)
+RC kvNext (BT_ScanHandle *handle, Value **key, char **value, int *length)
 {
-	free(handle);
+	BTree *treeInfo = (BTree*)(handle->tree->mgmtData);
+	BTree *entry = scanForward(treeInfo, (BT_ScanMgmt*)(handle->mgmtData));
+	RC rc;
+
+	if(entry == NULL)
+	{
+		return RC_IM_NO_MORE_ENTRIES;
+	}
+
+	rc = readKVValue(treeInfo, entry, value, length);
+	if(rc != RC_OK)
+	{
+		return rc;
+	}
+
+	*key = (Value*)malloc(sizeof(Value));
+	copyValue(*key, &entry->value);
 	return RC_OK;
 }
 
@@ -613,6 +4666,7 @@ RC closeTreeScan (BT_ScanHandle *handle)
  */
 char *printTree (BTreeHandle *tree)
 {
+	BTree *treeInfo = (BTree*)(tree->mgmtData);
 	int count = 1, tempCount =1;
 	int i;
 	char opString[500];
@@ -620,14 +4674,23 @@ char *printTree (BTreeHandle *tree)
 	char finalResult[500]="";
 	char TREE[500] = "";
 
+	//only the B+ tree has nodes to print
+	if(treeInfo->engine != IE_BTREE)
+	{
+		printf("%s: no B+ tree representation for this engine\n",tree->idxId);
+		return tree->idxId;
+	}
+
+	flushMessageBuffer(treeInfo);
+
 	strcpy(opString,"1,");
 	int compare = 2;
 
-	for(i=0;i<numOfKeys;i++)
+	for(i=0;i<treeInfo->numOfKeys;i++)
 	{
 		if(i%(compare) == 0 && i!=0)
 		{
-			sprintf(newopString,"%d",AllocBTree[i]->value.v.intV);
+			sprintf(newopString,"%d",treeInfo->entries[i]->value.v.intV);
 			strcat(opString,newopString);
 			strcat(opString,",");
 			sprintf(newopString,"%d",(tempCount+1));
@@ -643,13 +4706,13 @@ char *printTree (BTreeHandle *tree)
 			strcpy(finalResult,newopString);
 			strcat(finalResult,"\n");
 		}
-		sprintf(newopString,"%d",AllocBTree[i]->rid.page);
+		sprintf(newopString,"%d",treeInfo->entries[i]->rid.page);
 		strcat(finalResult,newopString);
 		strcat(finalResult,".");
-		sprintf(newopString,"%d",AllocBTree[i]->rid.slot);
+		sprintf(newopString,"%d",treeInfo->entries[i]->rid.slot);
 		strcat(finalResult,newopString);
 		strcat(finalResult,", ");
-		sprintf(newopString,"%d",AllocBTree[i]->value.v.intV);
+		sprintf(newopString,"%d",treeInfo->entries[i]->value.v.intV);
 		strcat(finalResult,newopString);
 		strcat(finalResult,",");
 		if(!(i%(compare) == 0 && i!=0))
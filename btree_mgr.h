@@ -3,6 +3,7 @@
 
 #include "dberror.h"
 #include "tables.h"
+#include "expr.h"
 
 // structure for accessing btrees
 typedef struct BTreeHandle {
@@ -16,29 +17,100 @@ typedef struct BT_ScanHandle {
   void *mgmtData;
 } BT_ScanHandle;
 
+// shape of a B+ tree index returned by getBtreeStats, level 0 is the root
+#define BT_STATS_MAX_LEVELS 32
+
+typedef struct BTreeStats {
+  int height;			// number of levels, 0 for an empty tree
+  int numOfNodes;
+  int nodesPerLevel[BT_STATS_MAX_LEVELS];
+  double avgFillFactor;		// keys of a node / N, averaged over all nodes
+  double minFillFactor;
+  double bytesPerEntry;		// memory of an entry, its key, payload and value and its array slot
+  double fragmentation;		// share of neighbouring entries that are not next to each other in memory
+  double residentPages;		// share of the index pages held in the buffer pool
+} BTreeStats;
+
+// index engines that can serve an index behind this interface
+typedef enum IndexEngine {
+  IE_BTREE = 0,		// sorted entries, the default
+  IE_ART = 1,		// in-memory Adaptive Radix Tree
+  IE_HASH = 2,		// extendible hashing in the index pages, no scans
+  IE_FROZEN = 3		// read-only export opened with mmap, see exportFrozenBtree
+} IndexEngine;
+
 // init and shutdown index manager
 extern RC initIndexManager (void *mgmtData);
 extern RC shutdownIndexManager ();
 
 // create, destroy, open, and close an btree index
 extern RC createBtree (char *idxId, DataType keyType, int n);
+extern RC createBtreeWithEngine (char *idxId, DataType keyType, int n, IndexEngine engine);
+extern RC createBtreeWithNodeSize (char *idxId, DataType keyType, int nodePages);
+extern RC createBtreeWithPayload (char *idxId, DataType keyType, int n, int numIncluded, DataType *includedTypes);
 extern RC openBtree (BTreeHandle **tree, char *idxId);
 extern RC closeBtree (BTreeHandle *tree);
 extern RC deleteBtree (char *idxId);
+extern RC exportFrozenBtree (BTreeHandle *tree, char *fileName);
+
+// build an index over an attribute of a table from one scan of it
+extern RC createIndexOnTable (RM_TableData *rel, int attrNum, char *idxId);
+extern RC createPartialIndexOnTable (RM_TableData *rel, int attrNum, char *idxId, Expr *cond);
+extern RC insertTableRecord (BTreeHandle *tree, RM_TableData *rel, Record *record);
 
 // access information about a b-tree
 extern RC getNumNodes (BTreeHandle *tree, int *result);
 extern RC getNumEntries (BTreeHandle *tree, int *result);
 extern RC getKeyType (BTreeHandle *tree, DataType *result);
+extern RC getBtreeStats (BTreeHandle *tree, BTreeStats *stats);
+
+// bloom filter used to answer findKey for absent keys, 0 bits per key disables it
+extern RC setBloomFilter (BTreeHandle *tree, int bitsPerKey);
+
+// learned index over DT_INT keys with the given maximum position error, 0 disables it
+extern RC setLearnedIndex (BTreeHandle *tree, int maxError);
+
+// read-only copy of the keys in Eytzinger (breadth first) order for searches, stale after a write
+extern RC setEytzingerLayout (BTreeHandle *tree, bool enabled);
+
+// interpolation search over DT_INT keys that look uniform, on by default
+extern RC setInterpolationSearch (BTreeHandle *tree, bool enabled);
+
+// write buffering mode, inserts and deletes are buffered as messages, 0 disables it
+extern RC setWriteBuffer (BTreeHandle *tree, int capacity);
+extern RC mergeWriteBuffer (BTreeHandle *tree);
+
+// copy the entries into one block in key order, leaving room for inserts in the entry array
+extern RC defragmentBtree (BTreeHandle *tree);
+
+// copy-on-write mode, scans read a snapshot of the entries taken when they were opened
+extern RC setCopyOnWrite (BTreeHandle *tree, bool enabled);
 
 // index access
 extern RC findKey (BTreeHandle *tree, Value *key, RID *result);
 extern RC insertKey (BTreeHandle *tree, Value *key, RID rid);
+extern RC insertKeyWithPayload (BTreeHandle *tree, Value *key, RID rid, Value **payload);
+extern RC insertKeys (BTreeHandle *tree, Value **keys, RID *rids, int n);
+extern RC insertKeysWithPayload (BTreeHandle *tree, Value **keys, RID *rids, Value ***payloads, int n);
 extern RC deleteKey (BTreeHandle *tree, Value *key);
+extern RC countKeyRange (BTreeHandle *tree, Value *low, Value *high, int *result);
+extern RC estimateRangeCount (BTreeHandle *tree, Value *low, Value *high, int *result);
+extern RC getKeyRank (BTreeHandle *tree, Value *key, int *result);
+extern RC getKeyAtRank (BTreeHandle *tree, int rank, Value **result);
 extern RC openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle);
+extern RC openTreeScanReverse (BTreeHandle *tree, BT_ScanHandle **handle);
 extern RC nextEntry (BT_ScanHandle *handle, RID *result);
+extern RC prevEntry (BT_ScanHandle *handle, RID *result);
+extern RC nextEntryWithPayload (BT_ScanHandle *handle, Value **key, RID *result, Value **payload);
 extern RC closeTreeScan (BT_ScanHandle *handle);
 
+// key-value access, values are stored in the entries and large ones in overflow pages
+extern RC kvPut (BTreeHandle *tree, Value *key, char *value, int length);
+extern RC kvGet (BTreeHandle *tree, Value *key, char **value, int *length);
+extern RC kvDelete (BTreeHandle *tree, Value *key);
+extern RC kvScan (BTreeHandle *tree, BT_ScanHandle **handle);
+extern RC kvNext (BT_ScanHandle *handle, Value **key, char **value, int *length);
+
 // debug and test functions
 extern char *printTree (BTreeHandle *tree);
 
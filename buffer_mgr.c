@@ -210,6 +210,58 @@ RC forceFlushPool(BM_BufferPool *const bm)
 	return RC_OK;
 }
 
+/*
+ * This function writes back the dirty frames holding the pages first .. first + numPages - 1
+ * and empties those frames, so that the pages can be read or written directly in the page file
+ * (readBlocks/writeBlocks) without the pool keeping another copy of them.
+ * A pinned page cannot be dropped, then RC_WRITE_FAILED is returned
+ */
+RC discardPages(BM_BufferPool *const bm, const PageNumber first, const int numPages)
+{
+	BM_BufferPool_Mgmt *bp_mgmt = bm->mgmtData;
+	PageFrame *frame = bp_mgmt->head;
+	SM_FileHandle fh;
+	bool opened = FALSE;
+	RC rc = RC_OK;
+
+	do
+	{
+		if(frame->pageNum >= first && frame->pageNum < first + numPages)
+		{
+			if(frame->fixCount > 0)
+			{
+				rc = RC_WRITE_FAILED;
+			}
+			else
+			{
+				//the page file is only opened when a frame has to be written back
+				if(frame->dirtyFlag == 1)
+				{
+					if(!opened && openPageFile((char *)(bm->pageFile), &fh) != RC_OK)
+						return RC_FILE_NOT_FOUND;
+					opened = TRUE;
+					if(writeBlock(frame->pageNum, &fh, frame->data) != RC_OK)
+					{
+						closePageFile(&fh);
+						return RC_WRITE_FAILED;
+					}
+					bp_mgmt->numWrite++;
+				}
+
+				//the frame stays counted as occupied, the replacement strategy reuses it
+				frame->pageNum = NO_PAGE;
+				frame->dirtyFlag = 0;
+				frame->refBit = 0;
+			}
+		}
+		frame = frame->next;
+	}while(frame != bp_mgmt->head);
+
+	if(opened)
+		closePageFile(&fh);
+	return rc;
+}
+
 // Buffer Manager Interface Access Pages
 
 /*
@@ -314,16 +366,13 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumber
 	switch(bm->strategy)
 	{
 	case RS_FIFO:
-		pinPageFIFO(bm, page, pageNum);
-		break;
+		return pinPageFIFO(bm, page, pageNum);
 
 	case RS_LRU:
-		pinPageLRU(bm,page,pageNum);
-		break;
+		return pinPageLRU(bm,page,pageNum);
 
 	case RS_CLOCK:
-		pinPageCLOCK(bm,page,pageNum);
-		break;
+		return pinPageCLOCK(bm,page,pageNum);
 	}
 	return RC_OK;
 }
@@ -336,11 +385,10 @@ RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumber
 RC pinPageFIFO(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumber pageNum)
 {
 	SM_FileHandle fh;
+	RC rc;
 	BM_BufferPool_Mgmt *bp_mgmt = bm->mgmtData;
 	PageFrame *frame = bp_mgmt->head;
 
-	openPageFile((char*) bm->pageFile,&fh);
-
 	// if page is already present in the buffer pool
 	do
 	{
@@ -357,6 +405,9 @@ RC pinPageFIFO(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumb
 		frame = frame->next;
 	}while(frame!= bp_mgmt->head);
 
+	//the page file is only opened when the page has to be read
+	openPageFile((char*) bm->pageFile,&fh);
+
 	//if there are remaining frames in the buffer pool, i.e. bufferpool is not fully occupied
 	//pin the pages in the empty spaces
 	if(bp_mgmt->occupiedCount < bm->numPages)
@@ -412,11 +463,13 @@ RC pinPageFIFO(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumb
 	//ensure if the pageFile has the required number of pages, if not create those
 	ensureCapacity((pageNum+1),&fh);
 
-	//read the block into pageFrame
-	if(readBlock(pageNum, &fh,frame->data)!=RC_OK)
+	//read the block into pageFrame, a page that fails its checksum does not stay in the frame
+	if((rc = readBlock(pageNum, &fh,frame->data))!=RC_OK)
 	{
+		frame->pageNum = NO_PAGE;
+		frame->fixCount--;
 		closePageFile(&fh);
-		return RC_READ_NON_EXISTING_PAGE;
+		return rc;
 	}
 
 	//increment the num of read operations
@@ -439,12 +492,11 @@ RC pinPageFIFO(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumb
  */
 RC pinPageLRU(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumber pageNum)
 {
+	RC rc;
 	BM_BufferPool_Mgmt *bp_mgmt = bm->mgmtData;
 	PageFrame *frame = bp_mgmt->head;
 	SM_FileHandle fh;
 
-	openPageFile((char*)bm->pageFile,&fh);
-
 	//check if frame already in buffer pool
 	do
 	{
@@ -467,6 +519,9 @@ RC pinPageLRU(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumbe
 
 	}while(frame!= bp_mgmt->head);
 
+	//the page file is only opened when the page has to be read
+	openPageFile((char*)bm->pageFile,&fh);
+
 	//if there are empty spaces in the bufferPool , then fill in those frames first
 	if(bp_mgmt->occupiedCount < bm->numPages)
 	{
@@ -531,9 +586,12 @@ RC pinPageLRU(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumbe
 	}
 
 	ensureCapacity((pageNum+1),&fh);
-	if(readBlock(pageNum, &fh,frame->data)!=RC_OK)
+	if((rc = readBlock(pageNum, &fh,frame->data))!=RC_OK)
 	{
-		return RC_READ_NON_EXISTING_PAGE;
+		frame->pageNum = NO_PAGE;
+		frame->fixCount--;
+		closePageFile(&fh);
+		return rc;
 	}
 	bp_mgmt->numRead++;
 
@@ -557,10 +615,10 @@ RC pinPageLRU(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumbe
 RC pinPageCLOCK(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNumber pageNum)
 {
 	SM_FileHandle fh;
+	RC rc;
 	BM_BufferPool_Mgmt *bp_mgmt = bm->mgmtData;
 	PageFrame *frame = bp_mgmt->head;
 	PageFrame *temp;
-	openPageFile((char*)bm->pageFile,&fh);
 
 	// if frame already in buffer pool
 
@@ -581,6 +639,9 @@ RC pinPageCLOCK(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNum
 		frame = frame->next;
 	}while(frame!=bp_mgmt->head);
 
+	//the page file is only opened when the page has to be read
+	openPageFile((char*)bm->pageFile,&fh);
+
 	//if space present will be executed at the start when all the frames are empty
 	if(bp_mgmt->occupiedCount < bm->numPages)
 	{
@@ -650,10 +711,12 @@ RC pinPageCLOCK(BM_BufferPool *const bm, BM_PageHandle *const page,const PageNum
 	}
 	ensureCapacity((pageNum+1),&fh);
 
-	if(readBlock(pageNum, &fh,frame->data)!=RC_OK)
+	if((rc = readBlock(pageNum, &fh,frame->data))!=RC_OK)
 	{
+		frame->pageNum = NO_PAGE;
+		frame->fixCount--;
 		closePageFile(&fh);
-		return RC_READ_NON_EXISTING_PAGE;
+		return rc;
 	}
 
 	bp_mgmt->numRead++;
@@ -46,6 +46,7 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 		  void *stratData);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC discardPages(BM_BufferPool *const bm, const PageNumber first, const int numPages);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -0,0 +1,136 @@
+#include "string.h"
+#include "crc32c.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include "nmmintrin.h"
+#define CRC32C_HAVE_SSE42 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include "arm_acle.h"
+#define CRC32C_HAVE_ARM_CRC 1
+#endif
+
+//reflected Castagnoli polynomial
+#define CRC32C_POLY 0x82F63B78
+
+//tables of the slicing by 8 fallback, table[k][b] is the crc of byte b followed by k zero bytes
+static uint32_t crcTable[8][256];
+static int crcTableReady = 0;
+
+static void buildCrcTable (void)
+{
+	uint32_t crc;
+	int b, k, bit;
+
+	for(b = 0;b<256;b++)
+	{
+		crc = b;
+		for(bit = 0;bit<8;bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+		crcTable[0][b] = crc;
+	}
+	for(b = 0;b<256;b++)
+	{
+		crc = crcTable[0][b];
+		for(k = 1;k<8;k++)
+		{
+			crc = crcTable[0][crc & 0xFF] ^ (crc >> 8);
+			crcTable[k][b] = crc;
+		}
+	}
+	crcTableReady = 1;
+}
+
+/*
+ * Table driven crc, eight bytes per step
+ */
+static uint32_t crc32cTable (uint32_t crc, const unsigned char *p, size_t length)
+{
+	uint64_t word;
+
+	if(!crcTableReady)
+		buildCrcTable();
+
+	while(length >= 8)
+	{
+		//the tables are for little endian words
+		word = (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24
+			| (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+		word ^= crc;
+		crc = crcTable[7][word & 0xFF] ^ crcTable[6][(word >> 8) & 0xFF]
+			^ crcTable[5][(word >> 16) & 0xFF] ^ crcTable[4][(word >> 24) & 0xFF]
+			^ crcTable[3][(word >> 32) & 0xFF] ^ crcTable[2][(word >> 40) & 0xFF]
+			^ crcTable[1][(word >> 48) & 0xFF] ^ crcTable[0][word >> 56];
+		p += 8;
+		length -= 8;
+	}
+	while(length--)
+		crc = crcTable[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+#ifdef CRC32C_HAVE_SSE42
+/*
+ * crc with the crc32 instruction of SSE4.2, only called when the processor has it
+ */
+__attribute__((target("sse4.2")))
+static uint32_t crc32cSse42 (uint32_t crc, const unsigned char *p, size_t length)
+{
+	uint64_t crc64 = crc, word;
+
+	while(length >= 8)
+	{
+		memcpy(&word, p, sizeof(word));
+		crc64 = _mm_crc32_u64(crc64, word);
+		p += 8;
+		length -= 8;
+	}
+	crc = (uint32_t)crc64;
+	while(length--)
+		crc = _mm_crc32_u8(crc, *p++);
+	return crc;
+}
+#endif
+
+#ifdef CRC32C_HAVE_ARM_CRC
+/*
+ * crc with the crc32c instructions of ARMv8
+ */
+static uint32_t crc32cArm (uint32_t crc, const unsigned char *p, size_t length)
+{
+	uint64_t word;
+
+	while(length >= 8)
+	{
+		memcpy(&word, p, sizeof(word));
+		crc = __crc32cd(crc, word);
+		p += 8;
+		length -= 8;
+	}
+	while(length--)
+		crc = __crc32cb(crc, *p++);
+	return crc;
+}
+#endif
+
+uint32_t crc32c (const void *data, size_t length)
+{
+	const unsigned char *p = (const unsigned char*)data;
+	uint32_t crc = 0xFFFFFFFF;
+
+#if defined(CRC32C_HAVE_SSE42)
+	static int hasSse42 = -1;
+
+	//asked once, the answer does not change while the process runs
+	if(hasSse42 < 0)
+		hasSse42 = __builtin_cpu_supports("sse4.2") ? 1 : 0;
+	if(hasSse42)
+		crc = crc32cSse42(crc, p, length);
+	else
+		crc = crc32cTable(crc, p, length);
+#elif defined(CRC32C_HAVE_ARM_CRC)
+	crc = crc32cArm(crc, p, length);
+#else
+	crc = crc32cTable(crc, p, length);
+#endif
+	return ~crc;
+}
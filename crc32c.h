@@ -0,0 +1,12 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+#include "stdint.h"
+#include "stddef.h"
+
+// CRC32C (Castagnoli) of a buffer, used as the checksum of the pages of a page file.
+// It uses the CRC instructions of SSE4.2 or ARMv8 when the processor has them
+// and a table driven version otherwise, all of them give the same result
+extern uint32_t crc32c (const void *data, size_t length);
+
+#endif // CRC32C_H
@@ -14,6 +14,7 @@ typedef int RC;
 #define RC_FILE_HANDLE_NOT_INIT 2
 #define RC_WRITE_FAILED 3
 #define RC_READ_NON_EXISTING_PAGE 4
+#define RC_PAGE_CHECKSUM_MISMATCH 5
 
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
@@ -26,6 +27,14 @@ typedef int RC;
 #define RC_IM_KEY_ALREADY_EXISTS 301
 #define RC_IM_N_TO_LAGE 302
 #define RC_IM_NO_MORE_ENTRIES 303
+#define RC_IM_TOO_MANY_INCLUDED 304
+#define RC_IM_UNKNOWN_ENGINE 305
+#define RC_IM_NOT_SUPPORTED_BY_ENGINE 306
+#define RC_IM_HASH_BUCKET_FULL 307
+#define RC_IM_KEY_TYPE_NOT_SUPPORTED 308
+#define RC_IM_INDEX_READ_ONLY 309
+#define RC_IM_NO_SUCH_ATTRIBUTE 310
+#define RC_IM_CONDITION_TOO_LARGE 311
 
 #define RC_TABLE_ALREADY_EXISTS 400
 #define RC_RM_UPDATE_NOT_POSSIBLE_ON_DELETED_RECORD 401
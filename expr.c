@@ -25,6 +25,12 @@ valueEquals (Value *left, Value *right, Value *result)
   case DT_BOOL:
     result->v.boolV = (left->v.boolV == right->v.boolV);
     break;
+  case DT_INT64:
+    result->v.boolV = (left->v.int64V == right->v.int64V);
+    break;
+  case DT_DOUBLE:
+    result->v.boolV = (left->v.doubleV == right->v.doubleV);
+    break;
   case DT_STRING:
     result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) == 0);
     break;
@@ -48,6 +54,12 @@ valueSmaller (Value *left, Value *right, Value *result)
   case DT_FLOAT:
     result->v.boolV = (left->v.floatV < right->v.floatV);
     break;
+  case DT_INT64:
+    result->v.boolV = (left->v.int64V < right->v.int64V);
+    break;
+  case DT_DOUBLE:
+    result->v.boolV = (left->v.doubleV < right->v.doubleV);
+    break;
   case DT_BOOL:
     result->v.boolV = (left->v.boolV < right->v.boolV);
   case DT_STRING:
@@ -63,6 +63,12 @@ extern void freeVal(Value *val);
     case DT_BOOL:							\
       (_result)->v.boolV = _input->v.boolV;				\
       break;								\
+    case DT_INT64:							\
+      (_result)->v.int64V = _input->v.int64V;				\
+      break;								\
+    case DT_DOUBLE:							\
+      (_result)->v.doubleV = _input->v.doubleV;				\
+      break;								\
     }									\
 } while(0)
 
@@ -0,0 +1,299 @@
+#include "stdlib.h"
+#include "string.h"
+#include "fcntl.h"
+#include "unistd.h"
+#include "sys/mman.h"
+#include "sys/stat.h"
+#include "frozen_index.h"
+
+//The file starts with the magic, so openBtree can tell it from a page file
+#define FROZEN_MAGIC "BTFROZEN"
+#define FROZEN_MAGIC_LENGTH 8
+#define FROZEN_VERSION 1
+
+//Header at the start of the first page, the slots start on the second page
+typedef struct FrozenHeader
+{
+	char magic[FROZEN_MAGIC_LENGTH];
+	int version;
+	int keyType;
+	int n;
+	int numOfKeys;
+	int keyWidth;
+}FrozenHeader;
+
+/*
+ * Create a frozen index file for numOfKeys entries whose keys take keyWidth bytes,
+ * returns NULL if the file cannot be created
+ */
+FrozenWriter *frozenWriterOpen (char *fileName, DataType keyType, int n, int numOfKeys, int keyWidth)
+{
+	FrozenWriter *writer;
+	FrozenHeader *header;
+	char *headerPage;
+	FILE *file = fopen(fileName, "wb");
+
+	if(file == NULL)
+		return NULL;
+
+	headerPage = (char*)calloc(PAGE_SIZE, sizeof(char));
+	header = (FrozenHeader*)headerPage;
+	memcpy(header->magic, FROZEN_MAGIC, FROZEN_MAGIC_LENGTH);
+	header->version = FROZEN_VERSION;
+	header->keyType = keyType;
+	header->n = n;
+	header->numOfKeys = numOfKeys;
+	header->keyWidth = keyWidth;
+	fwrite(headerPage, PAGE_SIZE, 1, file);
+	free(headerPage);
+
+	writer = (FrozenWriter*)malloc(sizeof(FrozenWriter));
+	writer->file = file;
+	writer->keyWidth = keyWidth;
+	writer->slot = (char*)malloc(keyWidth + 2 * sizeof(int));
+	return writer;
+}
+
+/*
+ * Append the next entry, keys have to come in ascending order
+ */
+void frozenWriterAppend (FrozenWriter *writer, Value *key, RID rid)
+{
+	char *slot = writer->slot;
+	int boolKey;
+
+	memset(slot, 0, writer->keyWidth + 2 * sizeof(int));
+	switch(key->dt)
+	{
+	case DT_INT:
+		memcpy(slot, &key->v.intV, sizeof(int));
+		break;
+	case DT_FLOAT:
+		memcpy(slot, &key->v.floatV, sizeof(float));
+		break;
+	case DT_BOOL:
+		boolKey = key->v.boolV;
+		memcpy(slot, &boolKey, sizeof(int));
+		break;
+	case DT_STRING:
+		//the width leaves room for the terminating 0 of the longest key
+		strncpy(slot, key->v.stringV, writer->keyWidth);
+		break;
+	case DT_INT64:
+		memcpy(slot, &key->v.int64V, sizeof(long long));
+		break;
+	case DT_DOUBLE:
+		memcpy(slot, &key->v.doubleV, sizeof(double));
+		break;
+	}
+	memcpy(slot + writer->keyWidth, &rid.page, sizeof(int));
+	memcpy(slot + writer->keyWidth + sizeof(int), &rid.slot, sizeof(int));
+
+	fwrite(slot, writer->keyWidth + 2 * sizeof(int), 1, writer->file);
+}
+
+RC frozenWriterClose (FrozenWriter *writer)
+{
+	int failed = ferror(writer->file);
+
+	failed |= fclose(writer->file);
+	free(writer->slot);
+	free(writer);
+
+	if(failed)
+	{
+		THROW(RC_WRITE_FAILED, "could not write the frozen index file");
+	}
+	return RC_OK;
+}
+
+/*
+ * Check the magic at the start of a file
+ */
+bool isFrozenIndexFile (char *fileName)
+{
+	char magic[FROZEN_MAGIC_LENGTH];
+	FILE *file = fopen(fileName, "rb");
+	bool frozen = FALSE;
+
+	if(file == NULL)
+		return FALSE;
+
+	if(fread(magic, FROZEN_MAGIC_LENGTH, 1, file) == 1)
+		frozen = (memcmp(magic, FROZEN_MAGIC, FROZEN_MAGIC_LENGTH) == 0);
+	fclose(file);
+	return frozen;
+}
+
+/*
+ * Map a frozen index file read-only, nothing is read until a page is touched.
+ * returns NULL if the file is missing or not a complete frozen index
+ */
+FrozenIndex *frozenOpen (char *fileName)
+{
+	FrozenIndex *index;
+	FrozenHeader *header;
+	struct stat fileStat;
+	char *map;
+	int fd = open(fileName, O_RDONLY);
+
+	if(fd < 0)
+		return NULL;
+
+	if(fstat(fd, &fileStat) != 0 || fileStat.st_size < PAGE_SIZE)
+	{
+		close(fd);
+		return NULL;
+	}
+
+	//the mapping stays valid after the descriptor is closed
+	map = (char*)mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+		return NULL;
+
+	header = (FrozenHeader*)map;
+	if(memcmp(header->magic, FROZEN_MAGIC, FROZEN_MAGIC_LENGTH) != 0 || header->version != FROZEN_VERSION
+			|| fileStat.st_size < PAGE_SIZE + (off_t)header->numOfKeys * (off_t)(header->keyWidth + 2 * sizeof(int)))
+	{
+		munmap(map, fileStat.st_size);
+		return NULL;
+	}
+
+	index = (FrozenIndex*)malloc(sizeof(FrozenIndex));
+	index->map = map;
+	index->mapSize = fileStat.st_size;
+	index->keyType = header->keyType;
+	index->n = header->n;
+	index->numOfKeys = header->numOfKeys;
+	index->keyWidth = header->keyWidth;
+	index->entrySize = header->keyWidth + 2 * sizeof(int);
+	index->entries = map + PAGE_SIZE;
+	return index;
+}
+
+void frozenClose (FrozenIndex *index)
+{
+	munmap(index->map, index->mapSize);
+	free(index);
+}
+
+/*
+ * Compare the key of a slot with a key, returns <0, 0 or >0 like strcmp
+ */
+static int compareSlot (FrozenIndex *index, char *slot, Value *key)
+{
+	long long int64Key;
+	double doubleKey;
+
+	switch(index->keyType)
+	{
+	case DT_INT:
+		return (*(int*)slot > key->v.intV) - (*(int*)slot < key->v.intV);
+	case DT_FLOAT:
+		return (*(float*)slot > key->v.floatV) - (*(float*)slot < key->v.floatV);
+	case DT_STRING:
+		return strcmp(slot, key->v.stringV);
+	case DT_BOOL:
+		return *(int*)slot - key->v.boolV;
+	case DT_INT64:
+		memcpy(&int64Key, slot, sizeof(long long));
+		return (int64Key > key->v.int64V) - (int64Key < key->v.int64V);
+	case DT_DOUBLE:
+		memcpy(&doubleKey, slot, sizeof(double));
+		return (doubleKey > key->v.doubleV) - (doubleKey < key->v.doubleV);
+	}
+	return 0;
+}
+
+/*
+ * Binary search over the slots, returns the position of the first key >= key
+ * and sets found when that slot holds exactly the key
+ */
+int frozenSearch (FrozenIndex *index, Value *key, int *found)
+{
+	int low = 0, high = index->numOfKeys;
+
+	while(low < high)
+	{
+		int mid = low + (high - low) / 2;
+
+		if(compareSlot(index, index->entries + (size_t)mid * index->entrySize, key) < 0)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	*found = (low < index->numOfKeys && compareSlot(index, index->entries + (size_t)low * index->entrySize, key) == 0);
+	return low;
+}
+
+/*
+ * Read the key and RID of the slot at pos, a string key points into the mapping
+ */
+void frozenEntry (FrozenIndex *index, int pos, Value *key, RID *rid)
+{
+	char *slot = index->entries + (size_t)pos * index->entrySize;
+
+	key->dt = index->keyType;
+	switch(index->keyType)
+	{
+	case DT_INT:
+		key->v.intV = *(int*)slot;
+		break;
+	case DT_FLOAT:
+		key->v.floatV = *(float*)slot;
+		break;
+	case DT_STRING:
+		key->v.stringV = slot;
+		break;
+	case DT_BOOL:
+		key->v.boolV = *(int*)slot;
+		break;
+	case DT_INT64:
+		memcpy(&key->v.int64V, slot, sizeof(long long));
+		break;
+	case DT_DOUBLE:
+		memcpy(&key->v.doubleV, slot, sizeof(double));
+		break;
+	}
+	rid->page = *(int*)(slot + index->keyWidth);
+	rid->slot = *(int*)(slot + index->keyWidth + sizeof(int));
+}
+
+/*
+ * Ask the kernel to read the pages of count slots from pos on in the background,
+ * a scan calls it ahead of its position so the reads overlap with its work
+ */
+void frozenWillNeed (FrozenIndex *index, int pos, int count)
+{
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	size_t start = (size_t)(index->entries - index->map) + (size_t)pos * index->entrySize;
+	size_t end = start + (size_t)count * index->entrySize;
+
+	//madvise wants a page aligned address
+	start -= start % pageSize;
+	if(end > index->mapSize)
+		end = index->mapSize;
+	if(end > start)
+		madvise(index->map + start, end - start, MADV_WILLNEED);
+}
+
+/*
+ * Share of the pages of the mapping that are in the page cache, 0 if the kernel cannot tell
+ */
+double frozenResidentShare (FrozenIndex *index)
+{
+	size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+	size_t numOfPages = (index->mapSize + pageSize - 1) / pageSize;
+	unsigned char *vec = (unsigned char*)malloc(numOfPages);
+	size_t i, resident = 0;
+
+	if(mincore(index->map, index->mapSize, vec) == 0)
+	{
+		for(i = 0;i<numOfPages;i++)
+			resident += vec[i] & 1;
+	}
+	free(vec);
+	return (double)resident / numOfPages;
+}
@@ -0,0 +1,43 @@
+#ifndef FROZEN_INDEX_H
+#define FROZEN_INDEX_H
+
+#include "stdio.h"
+#include "dberror.h"
+#include "tables.h"
+
+// Read-only frozen index file: a header page followed by every entry packed
+// in key order as fixed size slots (key, page, slot). It is mapped with mmap,
+// so opening it reads nothing and processes share its pages through the page cache
+
+typedef struct FrozenIndex {
+  char *map;		// the mapped file
+  size_t mapSize;
+  DataType keyType;
+  int n;		// N of the index the file was exported from
+  int numOfKeys;
+  int keyWidth;		// bytes of the key in a slot
+  int entrySize;	// bytes of a slot
+  char *entries;	// first slot, right after the header page
+} FrozenIndex;
+
+typedef struct FrozenWriter {
+  FILE *file;
+  int keyWidth;
+  char *slot;
+} FrozenWriter;
+
+// writing, the entries have to be appended in key order
+extern FrozenWriter *frozenWriterOpen (char *fileName, DataType keyType, int n, int numOfKeys, int keyWidth);
+extern void frozenWriterAppend (FrozenWriter *writer, Value *key, RID rid);
+extern RC frozenWriterClose (FrozenWriter *writer);
+
+// reading
+extern bool isFrozenIndexFile (char *fileName);
+extern FrozenIndex *frozenOpen (char *fileName);
+extern void frozenClose (FrozenIndex *index);
+extern int frozenSearch (FrozenIndex *index, Value *key, int *found);
+extern void frozenEntry (FrozenIndex *index, int pos, Value *key, RID *rid);
+extern void frozenWillNeed (FrozenIndex *index, int pos, int count);
+extern double frozenResidentShare (FrozenIndex *index);
+
+#endif // FROZEN_INDEX_H
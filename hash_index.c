@@ -0,0 +1,409 @@
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include "hash_index.h"
+
+//Fields of the meta page
+#define HASH_META_DEPTH 0
+#define HASH_META_BUCKETS 1
+#define HASH_META_KEYS 2
+#define HASH_META_NEXT_FREE 3
+#define HASH_META_DIR_PAGES 4
+#define HASH_META_DIR_PAGE_LIST 5
+
+//Bucket numbers per directory page
+#define HASH_DIR_ENTRIES_PER_PAGE (PAGE_SIZE / (int)sizeof(int))
+
+//Limit of the global depth, the page list of the directory has to fit into the meta page
+#define HASH_MAX_DEPTH 19
+
+//A bucket page starts with its local depth, its number of entries and the bytes they use
+#define HASH_BUCKET_DEPTH 0
+#define HASH_BUCKET_COUNT 1
+#define HASH_BUCKET_USED 2
+#define HASH_BUCKET_HEADER (3 * (int)sizeof(int))
+
+//Entry of a bucket page, followed by the key bytes padded to 4 bytes
+typedef struct HashEntry
+{
+	unsigned int hash;
+	int page;
+	int slot;
+	int keyLength;
+}HashEntry;
+
+/*
+ * Number of bytes an entry with the given key length takes in a bucket
+ */
+static int entrySize (int keyLength)
+{
+	return sizeof(HashEntry) + ((keyLength + 3) & ~3);
+}
+
+/*
+ * Bucket of a hash value in a directory of the given depth
+ */
+static int directoryIndex (HashIndex *index, unsigned int hash)
+{
+	return hash & ((1u << index->globalDepth) - 1);
+}
+
+/*
+ * Hand out the next unused page of the file
+ */
+static int allocatePage (HashIndex *index)
+{
+	return index->nextFreePage++;
+}
+
+/*
+ * Write the in-memory fields back to the meta page
+ */
+static void writeMeta (HashIndex *index)
+{
+	BM_PageHandle ph;
+	int *meta;
+
+	pinPage(index->bm, &ph, index->metaPage);
+	meta = (int*)ph.data;
+	meta[HASH_META_DEPTH] = index->globalDepth;
+	meta[HASH_META_BUCKETS] = index->numOfBuckets;
+	meta[HASH_META_KEYS] = index->numOfKeys;
+	meta[HASH_META_NEXT_FREE] = index->nextFreePage;
+	meta[HASH_META_DIR_PAGES] = index->numOfDirPages;
+	memcpy(&meta[HASH_META_DIR_PAGE_LIST], index->dirPages, sizeof(int) * index->numOfDirPages);
+	markDirty(index->bm, &ph);
+	unpinPage(index->bm, &ph);
+}
+
+/*
+ * Bucket page stored in the directory entry idx
+ */
+static int readDirectory (HashIndex *index, int idx)
+{
+	BM_PageHandle ph;
+	int bucketPage;
+
+	pinPage(index->bm, &ph, index->dirPages[idx / HASH_DIR_ENTRIES_PER_PAGE]);
+	bucketPage = ((int*)ph.data)[idx % HASH_DIR_ENTRIES_PER_PAGE];
+	unpinPage(index->bm, &ph);
+	return bucketPage;
+}
+
+static void writeDirectory (HashIndex *index, int idx, int bucketPage)
+{
+	BM_PageHandle ph;
+
+	pinPage(index->bm, &ph, index->dirPages[idx / HASH_DIR_ENTRIES_PER_PAGE]);
+	((int*)ph.data)[idx % HASH_DIR_ENTRIES_PER_PAGE] = bucketPage;
+	markDirty(index->bm, &ph);
+	unpinPage(index->bm, &ph);
+}
+
+/*
+ * Start an empty bucket with the given local depth on a page
+ */
+static void initBucket (HashIndex *index, int bucketPage, int localDepth)
+{
+	BM_PageHandle ph;
+
+	pinPage(index->bm, &ph, bucketPage);
+	memset(ph.data, 0, PAGE_SIZE);
+	((int*)ph.data)[HASH_BUCKET_DEPTH] = localDepth;
+	markDirty(index->bm, &ph);
+	unpinPage(index->bm, &ph);
+}
+
+/*
+ * Offset of the entry of the key in a bucket page or -1,
+ * the stored hash is compared first so most other keys are skipped without a memcmp
+ */
+static int findEntry (char *data, unsigned int hash, unsigned char *key, int keyLength)
+{
+	int offset = HASH_BUCKET_HEADER;
+	int end = HASH_BUCKET_HEADER + ((int*)data)[HASH_BUCKET_USED];
+	HashEntry *entry;
+
+	while(offset < end)
+	{
+		entry = (HashEntry*)(data + offset);
+		if(entry->hash == hash && entry->keyLength == keyLength && memcmp(entry + 1, key, keyLength) == 0)
+			return offset;
+		offset += entrySize(entry->keyLength);
+	}
+	return -1;
+}
+
+/*
+ * Add an entry at the end of a bucket page, the caller checked that it fits
+ */
+static void appendEntry (char *data, unsigned int hash, unsigned char *key, int keyLength, int page, int slot)
+{
+	int *header = (int*)data;
+	HashEntry *entry = (HashEntry*)(data + HASH_BUCKET_HEADER + header[HASH_BUCKET_USED]);
+
+	entry->hash = hash;
+	entry->page = page;
+	entry->slot = slot;
+	entry->keyLength = keyLength;
+	memcpy(entry + 1, key, keyLength);
+
+	header[HASH_BUCKET_COUNT]++;
+	header[HASH_BUCKET_USED] += entrySize(keyLength);
+}
+
+/*
+ * Double the directory, the new upper half points to the same buckets as the lower half
+ */
+static void doubleDirectory (HashIndex *index)
+{
+	int size = 1 << index->globalDepth;
+	int needed = (2 * size + HASH_DIR_ENTRIES_PER_PAGE - 1) / HASH_DIR_ENTRIES_PER_PAGE;
+	int half, p;
+	BM_PageHandle src, dest;
+
+	while(index->numOfDirPages < needed)
+	{
+		index->dirPages = (int*)realloc(index->dirPages, sizeof(int) * (index->numOfDirPages + 1));
+		index->dirPages[index->numOfDirPages++] = allocatePage(index);
+	}
+
+	if(size < HASH_DIR_ENTRIES_PER_PAGE)
+	{
+		//both halves are on the first directory page
+		pinPage(index->bm, &dest, index->dirPages[0]);
+		memcpy(dest.data + size * sizeof(int), dest.data, size * sizeof(int));
+		markDirty(index->bm, &dest);
+		unpinPage(index->bm, &dest);
+	}
+	else
+	{
+		half = size / HASH_DIR_ENTRIES_PER_PAGE;
+		for(p = 0;p<half;p++)
+		{
+			pinPage(index->bm, &src, index->dirPages[p]);
+			pinPage(index->bm, &dest, index->dirPages[p + half]);
+			memcpy(dest.data, src.data, PAGE_SIZE);
+			markDirty(index->bm, &dest);
+			unpinPage(index->bm, &dest);
+			unpinPage(index->bm, &src);
+		}
+	}
+	index->globalDepth++;
+}
+
+/*
+ * Split the full bucket of directory entry idx into itself and a new bucket,
+ * only the directory entries of that bucket change, nothing else is rehashed
+ */
+static RC splitBucket (HashIndex *index, int idx)
+{
+	BM_PageHandle oldPh, newPh;
+	int oldPage = readDirectory(index, idx);
+	int localDepth, newPage, offset, end, low, j;
+	char *copy;
+	HashEntry *entry;
+
+	pinPage(index->bm, &oldPh, oldPage);
+	localDepth = ((int*)oldPh.data)[HASH_BUCKET_DEPTH];
+
+	//the bucket is the only one for its entries, the directory has to grow first
+	if(localDepth == index->globalDepth)
+	{
+		if(index->globalDepth == HASH_MAX_DEPTH)
+		{
+			unpinPage(index->bm, &oldPh);
+			THROW(RC_IM_HASH_BUCKET_FULL, "hash directory reached its maximum depth");
+		}
+		doubleDirectory(index);
+	}
+
+	newPage = allocatePage(index);
+	pinPage(index->bm, &newPh, newPage);
+	memset(newPh.data, 0, PAGE_SIZE);
+
+	//move the entries whose next hash bit is set into the new bucket
+	copy = (char*)malloc(PAGE_SIZE);
+	memcpy(copy, oldPh.data, PAGE_SIZE);
+	memset(oldPh.data, 0, PAGE_SIZE);
+	((int*)oldPh.data)[HASH_BUCKET_DEPTH] = localDepth + 1;
+	((int*)newPh.data)[HASH_BUCKET_DEPTH] = localDepth + 1;
+
+	offset = HASH_BUCKET_HEADER;
+	end = HASH_BUCKET_HEADER + ((int*)copy)[HASH_BUCKET_USED];
+	while(offset < end)
+	{
+		entry = (HashEntry*)(copy + offset);
+		appendEntry(((entry->hash >> localDepth) & 1) ? newPh.data : oldPh.data,
+				entry->hash, (unsigned char*)(entry + 1), entry->keyLength, entry->page, entry->slot);
+		offset += entrySize(entry->keyLength);
+	}
+	free(copy);
+
+	markDirty(index->bm, &oldPh);
+	markDirty(index->bm, &newPh);
+	unpinPage(index->bm, &newPh);
+	unpinPage(index->bm, &oldPh);
+
+	//the directory entries of the old bucket with the next bit set point to the new one
+	low = idx & ((1 << localDepth) - 1);
+	for(j = 1;j<(1 << (index->globalDepth - localDepth));j += 2)
+		writeDirectory(index, low | (j << localDepth), newPage);
+
+	index->numOfBuckets++;
+	writeMeta(index);
+	return RC_OK;
+}
+
+/*
+ * Open the hash index stored from metaPage on, a meta page without buckets
+ * belongs to a new index, which starts with one directory page and one bucket
+ */
+HashIndex *hashOpen (BM_BufferPool *bm, int metaPage)
+{
+	HashIndex *index = (HashIndex*)malloc(sizeof(HashIndex));
+	BM_PageHandle ph;
+	int *meta, bucketPage;
+
+	index->bm = bm;
+	index->metaPage = metaPage;
+
+	pinPage(bm, &ph, metaPage);
+	meta = (int*)ph.data;
+	index->numOfBuckets = meta[HASH_META_BUCKETS];
+
+	if(index->numOfBuckets > 0)
+	{
+		index->globalDepth = meta[HASH_META_DEPTH];
+		index->numOfKeys = meta[HASH_META_KEYS];
+		index->nextFreePage = meta[HASH_META_NEXT_FREE];
+		index->numOfDirPages = meta[HASH_META_DIR_PAGES];
+		index->dirPages = (int*)malloc(sizeof(int) * index->numOfDirPages);
+		memcpy(index->dirPages, &meta[HASH_META_DIR_PAGE_LIST], sizeof(int) * index->numOfDirPages);
+		unpinPage(bm, &ph);
+		return index;
+	}
+	unpinPage(bm, &ph);
+
+	index->globalDepth = 0;
+	index->numOfKeys = 0;
+	index->nextFreePage = metaPage + 1;
+	index->numOfDirPages = 1;
+	index->dirPages = (int*)malloc(sizeof(int));
+	index->dirPages[0] = allocatePage(index);
+
+	bucketPage = allocatePage(index);
+	initBucket(index, bucketPage, 0);
+	writeDirectory(index, 0, bucketPage);
+	index->numOfBuckets = 1;
+
+	writeMeta(index);
+	return index;
+}
+
+/*
+ * Store the meta page and free the index, the pages are written when the pool shuts down
+ */
+void hashClose (HashIndex *index)
+{
+	writeMeta(index);
+	free(index->dirPages);
+	free(index);
+}
+
+/*
+ * Find the RID of a key, touching one directory page and one bucket page
+ */
+RC hashFind (HashIndex *index, unsigned int hash, unsigned char *key, int keyLength, RID *result)
+{
+	BM_PageHandle ph;
+	HashEntry *entry;
+	int offset;
+
+	pinPage(index->bm, &ph, readDirectory(index, directoryIndex(index, hash)));
+	offset = findEntry(ph.data, hash, key, keyLength);
+	if(offset < 0)
+	{
+		unpinPage(index->bm, &ph);
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	entry = (HashEntry*)(ph.data + offset);
+	result->page = entry->page;
+	result->slot = entry->slot;
+	unpinPage(index->bm, &ph);
+	return RC_OK;
+}
+
+/*
+ * Insert a key, a full bucket is split and the insert retried
+ */
+RC hashInsert (HashIndex *index, unsigned int hash, unsigned char *key, int keyLength, RID rid)
+{
+	BM_PageHandle ph;
+	int size = entrySize(keyLength);
+	int idx;
+	RC rc;
+
+	if(HASH_BUCKET_HEADER + size > PAGE_SIZE)
+	{
+		THROW(RC_IM_HASH_BUCKET_FULL, "key does not fit into a hash bucket");
+	}
+
+	while(1)
+	{
+		idx = directoryIndex(index, hash);
+		pinPage(index->bm, &ph, readDirectory(index, idx));
+
+		if(findEntry(ph.data, hash, key, keyLength) >= 0)	//key already exists
+		{
+			unpinPage(index->bm, &ph);
+			return RC_IM_KEY_ALREADY_EXISTS;
+		}
+
+		if(HASH_BUCKET_HEADER + ((int*)ph.data)[HASH_BUCKET_USED] + size <= PAGE_SIZE)
+		{
+			appendEntry(ph.data, hash, key, keyLength, rid.page, rid.slot);
+			markDirty(index->bm, &ph);
+			unpinPage(index->bm, &ph);
+			index->numOfKeys++;
+			return RC_OK;
+		}
+		unpinPage(index->bm, &ph);
+
+		rc = splitBucket(index, idx);
+		if(rc != RC_OK)
+			return rc;
+	}
+}
+
+/*
+ * Delete a key from its bucket, buckets are not merged again
+ */
+RC hashDelete (HashIndex *index, unsigned int hash, unsigned char *key, int keyLength)
+{
+	BM_PageHandle ph;
+	int *header;
+	int offset, size, end;
+
+	pinPage(index->bm, &ph, readDirectory(index, directoryIndex(index, hash)));
+	offset = findEntry(ph.data, hash, key, keyLength);
+	if(offset < 0)
+	{
+		unpinPage(index->bm, &ph);
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	//close the gap left by the entry
+	header = (int*)ph.data;
+	size = entrySize(((HashEntry*)(ph.data + offset))->keyLength);
+	end = HASH_BUCKET_HEADER + header[HASH_BUCKET_USED];
+	memmove(ph.data + offset, ph.data + offset + size, end - offset - size);
+	header[HASH_BUCKET_COUNT]--;
+	header[HASH_BUCKET_USED] -= size;
+
+	markDirty(index->bm, &ph);
+	unpinPage(index->bm, &ph);
+	index->numOfKeys--;
+	return RC_OK;
+}
@@ -0,0 +1,31 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include "dberror.h"
+#include "tables.h"
+#include "buffer_mgr.h"
+
+// Extendible hash index stored in the pages of an index file,
+// every page is read and written through the buffer pool of the index
+
+typedef struct HashIndex {
+  BM_BufferPool *bm;
+  int metaPage;		// page holding the fields below
+  int globalDepth;	// the directory has 2^globalDepth entries
+  int numOfBuckets;
+  int numOfKeys;
+  int nextFreePage;	// first page of the file that is not used yet
+  int numOfDirPages;
+  int *dirPages;	// pages of the directory, in order
+} HashIndex;
+
+// open the index whose meta page is metaPage, an empty page starts a new index
+extern HashIndex *hashOpen (BM_BufferPool *bm, int metaPage);
+extern void hashClose (HashIndex *index);
+
+// point access on the encoded key bytes and their hash
+extern RC hashFind (HashIndex *index, unsigned int hash, unsigned char *key, int keyLength, RID *result);
+extern RC hashInsert (HashIndex *index, unsigned int hash, unsigned char *key, int keyLength, RID rid);
+extern RC hashDelete (HashIndex *index, unsigned int hash, unsigned char *key, int keyLength);
+
+#endif // HASH_INDEX_H
@@ -70,6 +70,12 @@ RC attrOffset (Schema *schema, int attrNum, int *result)
 		case DT_BOOL:
 			offset += sizeof(bool);
 			break;
+		case DT_INT64:
+			offset += sizeof(long long);
+			break;
+		case DT_DOUBLE:
+			offset += sizeof(double);
+			break;
 		}
 	}
 
@@ -147,11 +153,19 @@ RC createTable (char *name, Schema *schema)
 	 */
 	serializedData = serializeSchema(schema);
 
+	//the schema only fills the start of Page = 0, writeBlock writes the whole page
+	char *schemaPage = (char*)calloc(PAGE_SIZE, sizeof(char));
+	strncpy(schemaPage, serializedData, PAGE_SIZE - 1);
+	free(serializedData);
+
 	//Write the serialized data ontot Page = 0
-	if(writeBlock(0,&fh,serializedData)!=RC_OK)
+	if(writeBlock(0,&fh,schemaPage)!=RC_OK)
 	{
+		free(schemaPage);
 		return RC_WRITE_FAILED;
 	}
+	free(schemaPage);
+	closePageFile(&fh);
 
 	return RC_OK;	//all steps executed correctly, and Table is created, return RC_OK
 }
@@ -495,7 +509,7 @@ RC getRecord (RM_TableData *rel, RID id, Record *record)
 		pinPage(((RM_RecordMgmt *)rel->mgmtData)->bm, page, id.page);
 
 		//temp, to store the record data
-		char *record_data = (char*)malloc(sizeof(char) * strlen(page->data));
+		char *record_data = (char*)malloc(sizeof(char) * (strlen(page->data) + 1));
 
 		//copy the data
 		strcpy(record_data,page->data);
@@ -668,6 +682,10 @@ int getRecordSize(Schema *schema)
 			recordSize += sizeof(float);
 		else if(schema->dataTypes[i] == DT_BOOL)
 			recordSize += sizeof(bool);
+		else if(schema->dataTypes[i] == DT_INT64)
+			recordSize += sizeof(long long);
+		else if(schema->dataTypes[i] == DT_DOUBLE)
+			recordSize += sizeof(double);
 		else
 			recordSize += schema->typeLength[i];
 	}
@@ -784,6 +802,18 @@ RC getAttr (Record *record, Schema *schema, int attrNum, Value **value)
 		}
 		break;
 
+		case DT_INT64:
+		{
+			memcpy(&((*value)->v.int64V),attrData, sizeof(long long));
+		}
+		break;
+
+		case DT_DOUBLE:
+		{
+			memcpy(&((*value)->v.doubleV),attrData, sizeof(double));
+		}
+		break;
+
 		default:			//if different data encountered other than INT, FLOAT, BOOL, STRING return (EC 402)
 			return RC_RM_NO_DESERIALIZER_FOR_THIS_DATATYPE;
 	}
@@ -837,6 +867,18 @@ RC setAttr (Record *record, Schema *schema, int attrNum, Value *value)
 		}
 		break;
 
+		case DT_INT64:
+		{
+			memcpy(attrData,&(value->v.int64V), sizeof(long long));
+		}
+		break;
+
+		case DT_DOUBLE:
+		{
+			memcpy(attrData,&(value->v.doubleV), sizeof(double));
+		}
+		break;
+
 		default:
 			return RC_RM_NO_DESERIALIZER_FOR_THIS_DATATYPE;
 	}
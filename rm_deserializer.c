@@ -83,7 +83,7 @@ deserializeSchema(char *serializedSchemaData)
 
 	char *splitStart = (char*)malloc(sizeof(char));
 	char *splitEnd = (char*)malloc(sizeof(char));
-	char *splitString = (char*)malloc(sizeof(char));
+	char *splitString = (char*)calloc(PAGE_SIZE, sizeof(char));
 
 	//split on token values
 	splitStart = strtok(serializedSchemaData,"<");
@@ -107,7 +107,7 @@ deserializeSchema(char *serializedSchemaData)
   	{
   		splitEnd = strtok(NULL,": ");
 
-  		schema->attrNames[i] = (char*)malloc(sizeof(char*));
+  		schema->attrNames[i] = (char*)malloc(strlen(splitEnd) + 1);
   		strcpy(schema->attrNames[i],splitEnd);
 
   		if(i == lastAttr)
@@ -134,15 +134,22 @@ deserializeSchema(char *serializedSchemaData)
   			schema->dataTypes[i] = DT_BOOL;
   			schema->typeLength[i] = 0;
   		}
+  		else if(strcmp(splitEnd,"INT64")==0)
+  		{
+  			schema->dataTypes[i] = DT_INT64;
+  			schema->typeLength[i] = 0;
+  		}
+  		else if(strcmp(splitEnd,"DOUBLE")==0)
+  		{
+  			schema->dataTypes[i] = DT_DOUBLE;
+  			schema->typeLength[i] = 0;
+  		}
   		else
   		{
   			strcpy(splitString, splitEnd);
-  			char *str = (char*)malloc(sizeof(char));
+  			char str[16];
   			sprintf(str,"%d",i);
   			strcat(splitString,str);
-
-  			str = NULL;
-  			free(str);
   		}
   	}//end for()
 
@@ -161,7 +168,7 @@ deserializeSchema(char *serializedSchemaData)
   		//Find out the number of Keys & store the attrValues for those Keys
   		while(splitKey!=NULL)
   		{
-  			keyAttr[numOfKeys] = (char*)malloc(sizeof(char*));
+  			keyAttr[numOfKeys] = (char*)malloc(strlen(splitKey) + 1);
   			strcpy(keyAttr[numOfKeys],splitKey);
   			numOfKeys++;
   			splitKey = strtok(NULL,", ");
@@ -227,10 +234,12 @@ deserializeRecord(char *desiralize_record_str, Schema *schema)
 	int intVal;
 	float floatVal;
 	bool boolVal;
+	long long int64Val;
+	double doubleVal;
 
 	Value *value;
-	Record *record = (Record*)malloc(sizeof(Record*));
-	record->data = (char*)malloc(sizeof(char*));
+	Record *record = (Record*)malloc(sizeof(Record));
+	record->data = (char*)calloc(getRecordSize(schema), sizeof(char));
 
 	char *splitStart, *splitEnd;
 
@@ -272,6 +281,20 @@ deserializeRecord(char *desiralize_record_str, Schema *schema)
 			free(value);
 			break;
 
+		case DT_INT64:
+			int64Val = strtoll(splitEnd, NULL, 10);
+			MAKE_VALUE(value,DT_INT64,int64Val);
+			setAttr(record,schema,i,value);
+			free(value);
+			break;
+
+		case DT_DOUBLE:
+			doubleVal = strtod(splitEnd, NULL);
+			MAKE_VALUE(value,DT_DOUBLE,doubleVal);
+			setAttr(record,schema,i,value);
+			free(value);
+			break;
+
 		case DT_STRING:
 			MAKE_STRING_VALUE(value,splitEnd);
 			setAttr (record,schema,i,value);
@@ -134,6 +134,12 @@ serializeSchema(Schema *schema)
 	case DT_BOOL:
 	  APPEND_STRING(result,"BOOL");
 	  break;
+	case DT_INT64:
+	  APPEND_STRING(result,"INT64");
+	  break;
+	case DT_DOUBLE:
+	  APPEND_STRING(result,"DOUBLE");
+	  break;
 	}
     }
   APPEND_STRING(result,")");
@@ -215,6 +221,20 @@ serializeAttr(Record *record, Schema *schema, int attrNum)
 	APPEND(result, "%s:%s", schema->attrNames[attrNum], val ? "TRUE" : "FALSE");
       }
       break;
+    case DT_INT64:
+      {
+	long long val;
+	memcpy(&val,attrData, sizeof(long long));
+	APPEND(result, "%s:%lld", schema->attrNames[attrNum], val);
+      }
+      break;
+    case DT_DOUBLE:
+      {
+	double val;
+	memcpy(&val,attrData, sizeof(double));
+	APPEND(result, "%s:%.17g", schema->attrNames[attrNum], val);
+      }
+      break;
     default:
       return "NO SERIALIZER FOR DATATYPE";
     }
@@ -242,6 +262,12 @@ serializeValue(Value *val)
     case DT_BOOL:
       APPEND_STRING(result, ((val->v.boolV) ? "true" : "false"));
       break;
+    case DT_INT64:
+      APPEND(result,"%lld",val->v.int64V);
+      break;
+    case DT_DOUBLE:
+      APPEND(result,"%.17g",val->v.doubleV);
+      break;
     }
 
   RETURN_STRING(result);
@@ -271,6 +297,14 @@ stringToValue(char *val)
       result->dt = DT_BOOL;
       result->v.boolV = (val[1] == 't') ? TRUE : FALSE;
       break;
+    case 'l':
+      result->dt = DT_INT64;
+      result->v.int64V = strtoll(val + 1, NULL, 10);
+      break;
+    case 'd':
+      result->dt = DT_DOUBLE;
+      result->v.doubleV = strtod(val + 1, NULL);
+      break;
     default:
       result->dt = DT_INT;
       result->v.intV = -1;
@@ -302,6 +336,12 @@ attrOffset (Schema *schema, int attrNum, int *result)
       case DT_BOOL:
 	offset += sizeof(bool);
 	break;
+      case DT_INT64:
+	offset += sizeof(long long);
+	break;
+      case DT_DOUBLE:
+	offset += sizeof(double);
+	break;
       }
   
   *result = offset;
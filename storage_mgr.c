@@ -5,10 +5,52 @@
  */
 
 #include "storage_mgr.h"
+#include "crc32c.h"
 #include "stdio.h"
 #include "stdlib.h"
 #include "string.h"
 
+//On disk every block is a frame, a page header followed by the PAGE_SIZE bytes of the page.
+//The frames start after the file header page
+#define SM_FRAME_SIZE (SM_PAGE_HEADER_SIZE + PAGE_SIZE)
+#define SM_FRAME_OFFSET(pageNum) ((long)PAGE_SIZE + (long)(pageNum) * SM_FRAME_SIZE)
+
+//Page header, the checksum covers the page number and the page
+typedef struct SM_PageHeader
+{
+	uint32_t checksum;	//CRC32C of the rest of the frame
+	int32_t pageNum;	//the block the frame was written for
+}SM_PageHeader;
+
+/*
+ * Fill the page header of a frame whose page has been copied in
+ */
+static void sealFrame (int pageNum, char *frame)
+{
+	SM_PageHeader header;
+
+	header.pageNum = pageNum;
+	memcpy(frame + sizeof(uint32_t), &header.pageNum, sizeof(int32_t));
+	header.checksum = crc32c(frame + sizeof(uint32_t), SM_FRAME_SIZE - sizeof(uint32_t));
+	memcpy(frame, &header.checksum, sizeof(uint32_t));
+}
+
+/*
+ * Check a frame read from the file, a page that was torn, changed on disk
+ * or written to the wrong place gives RC_PAGE_CHECKSUM_MISMATCH
+ */
+static RC checkFrame (int pageNum, char *frame)
+{
+	SM_PageHeader header;
+
+	memcpy(&header, frame, sizeof(SM_PageHeader));
+	if(header.pageNum != pageNum || header.checksum != crc32c(frame + sizeof(uint32_t), SM_FRAME_SIZE - sizeof(uint32_t)))
+	{
+		return RC_PAGE_CHECKSUM_MISMATCH;
+	}
+	return RC_OK;
+}
+
 /* manipulating page files */
 void initStorageManager (void)
 {
@@ -23,14 +65,15 @@ RC createPageFile (char *fileName)
 {
 	FILE *fptr;		//file pointer
 
-	char *firstPage, *headerPage;
+	char firstPage[SM_FRAME_SIZE], *headerPage;
 
 	fptr = fopen(fileName, "w");	//Open the filePage in write mode
 
 	if(fptr!=NULL)	//if file exists
 	{
-		//allocate firstPage to store the actual data
-		firstPage = (char*)calloc(PAGE_SIZE, sizeof(char));
+		//the firstPage holds '\0' bytes
+		memset(firstPage, 0, SM_FRAME_SIZE);
+		sealFrame(0, firstPage);
 
 		//allocate headgerPage to store file infor like total number of pages
 		headerPage = (char*)calloc(PAGE_SIZE, sizeof(char));
@@ -41,12 +84,12 @@ RC createPageFile (char *fileName)
 		//write the headerPage with total no. of Pages
 		fwrite(headerPage, PAGE_SIZE, 1, fptr);
 
-		//write the firstPage with '\0' bytes
-		fwrite(firstPage, PAGE_SIZE, 1, fptr);
+		//write the firstPage after the headerPage
+		fseek(fptr, SM_FRAME_OFFSET(0), SEEK_SET);
+		fwrite(firstPage, SM_FRAME_SIZE, 1, fptr);
 
 		//free memory to avoid memory leaks
 		free(headerPage);
-		free(firstPage);
 
 		fclose(fptr);	//Close the file
 
@@ -132,9 +175,13 @@ RC destroyPageFile (char *fileName)
 /*
  * This method reads the pageNum(th) block from a file and stores its content in the memory pointed to by the memPage page handle.
  * If the file has less than pageNum pages, it return RC_READ_NON_EXISTING_PAGE.
+ * If the checksum in the page header does not match, it returns RC_PAGE_CHECKSUM_MISMATCH.
  */
 RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
+	char frame[SM_FRAME_SIZE];
+	RC rc;
+
 	//check if PageNum is Valid
 	if(pageNum<0 || pageNum>fHandle->totalNumPages - 1)
 	{
@@ -142,10 +189,18 @@ RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 	}
 
 	//if seeking the file ptr is successful then read the page into memPage
-	if(!fseek(fHandle->mgmtInfo,(pageNum+1)*PAGE_SIZE,SEEK_SET))
+	if(!fseek(fHandle->mgmtInfo,SM_FRAME_OFFSET(pageNum),SEEK_SET))
 	{
-		//read the block into memPage
-		fread(memPage,sizeof(char),PAGE_SIZE,fHandle->mgmtInfo);
+		//read the block with its page header
+		if(fread(frame,SM_FRAME_SIZE,1,fHandle->mgmtInfo) != 1)
+		{
+			return RC_READ_NON_EXISTING_PAGE;
+		}
+		if((rc = checkFrame(pageNum, frame)) != RC_OK)
+		{
+			return rc;
+		}
+		memcpy(memPage, frame + SM_PAGE_HEADER_SIZE, PAGE_SIZE);
 		fHandle->curPagePos = pageNum;	//update the curr page pos to most recently read page
 
 		return RC_OK;
@@ -154,6 +209,51 @@ RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 		return RC_READ_NON_EXISTING_PAGE;
 }
 
+/*
+ * This method reads numPages consecutive blocks starting at pageNum with a single read
+ * into memPage, which must hold numPages * PAGE_SIZE bytes.
+ * If the file ends before the last block, it returns RC_READ_NON_EXISTING_PAGE,
+ * and RC_PAGE_CHECKSUM_MISMATCH if the checksum of one of the blocks does not match.
+ */
+RC readBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPage)
+{
+	char *frames;
+	int i;
+	RC rc = RC_OK;
+
+	//check if all the pages exist
+	if(pageNum<0 || numPages<1 || pageNum + numPages > fHandle->totalNumPages)
+	{
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	if(fseek(fHandle->mgmtInfo,SM_FRAME_OFFSET(pageNum),SEEK_SET))
+	{
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	//read the whole run of blocks at once, then check and strip the page headers
+	frames = (char*)malloc((size_t)numPages * SM_FRAME_SIZE);
+	if(fread(frames,SM_FRAME_SIZE,numPages,fHandle->mgmtInfo) != (size_t)numPages)
+	{
+		free(frames);
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+	for(i = 0;i<numPages && rc == RC_OK;i++)
+	{
+		rc = checkFrame(pageNum + i, frames + (size_t)i * SM_FRAME_SIZE);
+		memcpy(memPage + (size_t)i * PAGE_SIZE, frames + (size_t)i * SM_FRAME_SIZE + SM_PAGE_HEADER_SIZE, PAGE_SIZE);
+	}
+	free(frames);
+	if(rc != RC_OK)
+	{
+		return rc;
+	}
+
+	fHandle->curPagePos = pageNum + numPages - 1;	//the last block read is the current one
+	return RC_OK;
+}
+
 /*
  * This method returns the current page position
  */
@@ -236,6 +336,8 @@ RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
  */
 RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 {
+	char frame[SM_FRAME_SIZE];
+
 	//check if pageNum is valid
 	if(pageNum > fHandle->totalNumPages -1 || pageNum < 0)
 	{
@@ -243,11 +345,18 @@ RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 	}
 	else
 	{
+		//put the page behind its page header
+		memcpy(frame + SM_PAGE_HEADER_SIZE, memPage, PAGE_SIZE);
+		sealFrame(pageNum, frame);
+
 		//seek to page number specified
-		fseek(fHandle->mgmtInfo,(pageNum+1)*PAGE_SIZE,SEEK_SET);
+		fseek(fHandle->mgmtInfo,SM_FRAME_OFFSET(pageNum),SEEK_SET);
 
 		//write the block
-		fwrite(memPage,PAGE_SIZE,1,fHandle->mgmtInfo);
+		if(fwrite(frame,SM_FRAME_SIZE,1,fHandle->mgmtInfo) != 1)
+		{
+			return RC_WRITE_FAILED;
+		}
 
 		//update the current page position
 		fHandle->curPagePos = pageNum;
@@ -257,6 +366,46 @@ RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage)
 
 }
 
+/*
+ * This method writes numPages consecutive blocks starting at pageNum with a single write
+ * from memPage, which holds numPages * PAGE_SIZE bytes.
+ * The blocks must exist, otherwise it gives an error RC_WRITE_FAILED
+ */
+RC writeBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPage)
+{
+	char *frames, *frame;
+	int i;
+	size_t written;
+
+	//check if all the pages exist
+	if(pageNum<0 || numPages<1 || pageNum + numPages > fHandle->totalNumPages)
+	{
+		return RC_WRITE_FAILED;
+	}
+
+	//give every block its page header
+	frames = (char*)malloc((size_t)numPages * SM_FRAME_SIZE);
+	for(i = 0;i<numPages;i++)
+	{
+		frame = frames + (size_t)i * SM_FRAME_SIZE;
+		memcpy(frame + SM_PAGE_HEADER_SIZE, memPage + (size_t)i * PAGE_SIZE, PAGE_SIZE);
+		sealFrame(pageNum + i, frame);
+	}
+
+	fseek(fHandle->mgmtInfo,SM_FRAME_OFFSET(pageNum),SEEK_SET);
+
+	//write the whole run of blocks at once
+	written = fwrite(frames,SM_FRAME_SIZE,numPages,fHandle->mgmtInfo);
+	free(frames);
+	if(written != (size_t)numPages)
+	{
+		return RC_WRITE_FAILED;
+	}
+
+	fHandle->curPagePos = pageNum + numPages - 1;
+	return RC_OK;
+}
+
 /*
  * This method is used to write onto the currently pointed block.
  * If the block is not present it gives and error RC_WRITE_FAILED
@@ -276,15 +425,16 @@ RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage)
  */
 RC appendEmptyBlock (SM_FileHandle *fHandle)
 {
-	//allocate a new empty page
+	//allocate a new empty page with its page header
 	char * newPage;
-	newPage = (char*)calloc(PAGE_SIZE, sizeof(char));
+	newPage = (char*)calloc(SM_FRAME_SIZE, sizeof(char));
+	sealFrame(fHandle->totalNumPages, newPage);
 
 	//seek to the page
-	fseek(fHandle->mgmtInfo,(fHandle->totalNumPages+1)*PAGE_SIZE,SEEK_SET);
+	fseek(fHandle->mgmtInfo,SM_FRAME_OFFSET(fHandle->totalNumPages),SEEK_SET);
 
 	//if write is possible, then write the empty block onto the pageFile
-	if(fwrite(newPage, PAGE_SIZE, 1, fHandle->mgmtInfo))
+	if(fwrite(newPage, SM_FRAME_SIZE, 1, fHandle->mgmtInfo))
 	{
 		//update the fileHandle attributes
 
@@ -299,7 +449,7 @@ RC appendEmptyBlock (SM_FileHandle *fHandle)
 		fprintf(fHandle->mgmtInfo, "%d", fHandle->totalNumPages);
 
 		//seek the pointer back again where it was last pointing
-		fseek(fHandle->mgmtInfo,(fHandle->totalNumPages+1)*PAGE_SIZE,SEEK_SET);
+		fseek(fHandle->mgmtInfo,SM_FRAME_OFFSET(fHandle->totalNumPages),SEEK_SET);
 
 		//free the memory allocated to avoid memory leaks
 		free(newPage);
@@ -8,7 +8,9 @@ typedef enum DataType {
   DT_INT = 0,
   DT_STRING = 1,
   DT_FLOAT = 2,
-  DT_BOOL = 3
+  DT_BOOL = 3,
+  DT_INT64 = 4,
+  DT_DOUBLE = 5
 } DataType;
 
 typedef struct Value {
@@ -18,6 +20,8 @@ typedef struct Value {
     char *stringV;
     float floatV;
     bool boolV;
+    long long int64V;
+    double doubleV;
   } v;
 } Value;
 
@@ -75,6 +79,12 @@ typedef struct RM_TableData
       case DT_BOOL:							\
 	(result)->v.boolV = value;					\
 	break;								\
+      case DT_INT64:							\
+	(result)->v.int64V = value;					\
+	break;								\
+      case DT_DOUBLE:							\
+	(result)->v.doubleV = value;					\
+	break;								\
       }									\
   } while(0)
 
@@ -87,5 +97,7 @@ extern char *serializeSchema(Schema *schema);
 extern char *serializeRecord(Record *record, Schema *schema);
 extern char *serializeAttr(Record *record, Schema *schema, int attrNum);
 extern char *serializeValue(Value *val);
+extern Schema *deserializeSchema(char *serializedSchemaData);
+extern Record *deserializeRecord(char *desiralize_record_str, Schema *schema);
 
 #endif
@@ -4,6 +4,10 @@
 #include "dberror.h"
 #include "expr.h"
 #include "btree_mgr.h"
+#include "record_mgr.h"
+#include "storage_mgr.h"
+#include "buffer_mgr.h"
+#include "crc32c.h"
 #include "tables.h"
 #include "test_helper.h"
 
@@ -16,6 +20,27 @@
 static void testInsertAndFind (void);
 static void testDelete (void);
 static void testIndexScan (void);
+static void testBatchInsert (void);
+static void testBloomFilter (void);
+static void testOrderStatistics (void);
+static void testCoveringScan (void);
+static void testWriteBuffer (void);
+static void testArtEngine (void);
+static void testHashEngine (void);
+static void testLearnedIndex (void);
+static void testFrozenIndex (void);
+static void testSnapshotScan (void);
+static void testDefragment (void);
+static void testNodeSize (void);
+static void testScanPrefetch (void);
+static void testIndexOnTable (void);
+static void testKeyValue (void);
+static void testWideKeys (void);
+static void testTreeStats (void);
+static void testInterpolationSearch (void);
+static void testEytzingerLayout (void);
+static void testPageChecksums (void);
+static void testRangeEstimate (void);
 
 // helper methods
 static Value **createValues (char **stringVals, int size);
@@ -34,6 +59,27 @@ main (void)
 	testInsertAndFind();
 	testDelete();
 	testIndexScan();
+	testBatchInsert();
+	testBloomFilter();
+	testOrderStatistics();
+	testCoveringScan();
+	testWriteBuffer();
+	testArtEngine();
+	testHashEngine();
+	testLearnedIndex();
+	testFrozenIndex();
+	testSnapshotScan();
+	testDefragment();
+	testNodeSize();
+	testScanPrefetch();
+	testIndexOnTable();
+	testKeyValue();
+	testWideKeys();
+	testTreeStats();
+	testInterpolationSearch();
+	testEytzingerLayout();
+	testPageChecksums();
+	testRangeEstimate();
 	testPrintTree();
 	return 0;
 }
@@ -302,6 +348,23 @@ testIndexScan (void)
 		}
 		ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "no error returned by scan");
 		ASSERT_EQUALS_INT(numInserts, i, "have seen all entries");
+
+		// walk back over the same cursor, we should see tuples in reverse sort order
+		while((rc = prevEntry(sc, &rid)) == RC_OK)
+		{
+			RID expRid = insert[--i];
+			ASSERT_EQUALS_RID(expRid, rid, "did we find the correct RID?");
+		}
+		ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "no error returned by reverse scan");
+		ASSERT_EQUALS_INT(0, i, "have seen all entries backwards");
+		closeTreeScan(sc);
+
+		// descending scan reading only the two greatest entries
+		openTreeScanReverse(tree, &sc);
+		TEST_CHECK(prevEntry(sc, &rid));
+		ASSERT_EQUALS_RID(insert[numInserts - 1], rid, "greatest key first");
+		TEST_CHECK(prevEntry(sc, &rid));
+		ASSERT_EQUALS_RID(insert[numInserts - 2], rid, "second greatest key next");
 		closeTreeScan(sc);
 
 		// cleanup
@@ -316,6 +379,2056 @@ testIndexScan (void)
 	TEST_DONE();
 }
 
+// ************************************************************ 
+void
+testBatchInsert (void)
+{
+	RID insert[] = {
+			{1,1},
+			{2,3},
+			{1,2},
+			{3,5},
+			{4,4},
+			{3,2},
+	};
+	int numInserts = 6;
+	Value **keys;
+	char *stringKeys[] = {
+			"i1",
+			"i11",
+			"i13",
+			"i17",
+			"i23",
+			"i52"
+	};
+
+	testName = "batch insertion and scan";
+	int i, testint, rc;
+	BTreeHandle *tree = NULL, *other = NULL;
+	BT_ScanHandle *sc = NULL;
+	RID rid;
+	Value *batchKeys[6];
+	RID batchRids[6];
+	int *permute;
+	Value *key, *bulkKeys[2000];
+	RID bulkRids[2000];
+	char *wideKey;
+
+	keys = createValues(stringKeys, numInserts);
+	permute = createPermutation(numInserts);
+
+	// init
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+
+	// insert one key on its own, then the whole set as an unsorted batch
+	TEST_CHECK(insertKey(tree, keys[2], insert[2]));
+	for(i = 0; i < numInserts; i++)
+	{
+		batchKeys[i] = keys[permute[i]];
+		batchRids[i] = insert[permute[i]];
+	}
+	rc = insertKeys(tree, batchKeys, batchRids, numInserts);
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, rc, "existing key in the batch is reported");
+
+	// check index stats
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(testint, numInserts, "number of entries in btree");
+	TEST_CHECK(getNumNodes(tree, &testint));
+	ASSERT_EQUALS_INT(testint, 4, "number of nodes in btree");
+
+	// search for keys
+	for(i = 0; i < numInserts; i++)
+	{
+		TEST_CHECK(findKey(tree, keys[i], &rid));
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+	}
+
+	// execute scan, we should see tuples in sort order
+	openTreeScan(tree, &sc);
+	i = 0;
+	while((rc = nextEntry(sc, &rid)) == RC_OK)
+	{
+		RID expRid = insert[i++];
+		ASSERT_EQUALS_RID(expRid, rid, "did we find the correct RID?");
+	}
+	ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "no error returned by scan");
+	ASSERT_EQUALS_INT(numInserts, i, "have seen all entries");
+	closeTreeScan(sc);
+
+	// every single key write pins the header page, a pin of a cached page must not use up file handles
+	for(i = 0; i < 25000; i++)
+	{
+		TEST_CHECK(deleteKey(tree, keys[0]));
+		TEST_CHECK(insertKey(tree, keys[0], insert[0]));
+	}
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// every index has its own entries, creating a second index leaves the first one alone
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(insertKeys(tree, keys, insert, numInserts));
+	TEST_CHECK(createBtree("testidx2", DT_INT, 2));
+	TEST_CHECK(openBtree(&other, "testidx2"));
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numInserts, testint, "second index did not wipe the first one");
+	MAKE_VALUE(key, DT_INT, 99);
+	TEST_CHECK(insertKey(other, key, insert[0]));
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, key, &rid), "key of the other index");
+	TEST_CHECK(getNumEntries(other, &testint));
+	ASSERT_EQUALS_INT(1, testint, "other index only has its own key");
+	TEST_CHECK(closeBtree(other));
+	TEST_CHECK(deleteBtree("testidx2"));
+
+	// a bulk load spanning many leaf pages is read back from the index file
+	for(i = 0; i < 2000; i++)
+	{
+		MAKE_VALUE(bulkKeys[i], DT_INT, 1000 + i);
+		bulkRids[i].page = i;
+		bulkRids[i].slot = i % 7;
+	}
+	TEST_CHECK(insertKeys(tree, bulkKeys, bulkRids, 2000));
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numInserts + 2000, testint, "entries after reopening the index");
+	for(i = 0; i < numInserts; i++)
+	{
+		TEST_CHECK(findKey(tree, keys[i], &rid));
+		ASSERT_EQUALS_RID(insert[i], rid, "RID read back from a leaf page");
+	}
+	for(i = 0; i < 2000; i += 111)
+	{
+		TEST_CHECK(findKey(tree, bulkKeys[i], &rid));
+		ASSERT_EQUALS_RID(bulkRids[i], rid, "RID read back from a leaf page");
+	}
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, key, &rid), "key of the deleted index");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	for(i = 0; i < 2000; i++)
+		free(bulkKeys[i]);
+	free(key);
+
+	// a string key larger than a page gets a leaf of several pages
+	wideKey = (char *) malloc(3 * PAGE_SIZE);
+	memset(wideKey, 'w', 3 * PAGE_SIZE - 1);
+	wideKey[3 * PAGE_SIZE - 1] = '\0';
+	TEST_CHECK(createBtree("testidx", DT_STRING, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	MAKE_STRING_VALUE(key, "a");
+	TEST_CHECK(insertKey(tree, key, insert[0]));
+	freeVal(key);
+	MAKE_STRING_VALUE(key, wideKey);
+	TEST_CHECK(insertKey(tree, key, insert[1]));
+	freeVal(key);
+	MAKE_STRING_VALUE(key, "z");
+	TEST_CHECK(insertKey(tree, key, insert[2]));
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(findKey(tree, key, &rid));
+	ASSERT_EQUALS_RID(insert[2], rid, "key behind the wide leaf");
+	freeVal(key);
+	MAKE_STRING_VALUE(key, wideKey);
+	TEST_CHECK(findKey(tree, key, &rid));
+	ASSERT_EQUALS_RID(insert[1], rid, "wide key read back");
+	freeVal(key);
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	free(wideKey);
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numInserts);
+	free(permute);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testBloomFilter (void)
+{
+	RID insert[] = {
+			{1,1},
+			{2,3},
+			{1,2},
+			{3,5},
+			{4,4},
+			{3,2},
+	};
+	int numInserts = 6;
+	Value **keys;
+	char *stringKeys[] = {
+			"i1",
+			"i11",
+			"i13",
+			"i17",
+			"i23",
+			"i52"
+	};
+
+	testName = "bloom filter on findKey";
+	int i, rc;
+	BTreeHandle *tree = NULL, *other = NULL;
+	RID rid;
+	Value *absent;
+
+	keys = createValues(stringKeys, numInserts);
+
+	// init
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(setBloomFilter(tree, 10));
+
+	// insert keys
+	for(i = 0; i < numInserts; i++)
+		TEST_CHECK(insertKey(tree, keys[i], insert[i]));
+
+	// reopen, the filter is read back from the index pages
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+
+	// present keys must always be found
+	for(i = 0; i < numInserts; i++)
+	{
+		TEST_CHECK(findKey(tree, keys[i], &rid));
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+	}
+
+	// absent keys are rejected
+	for(i = 100; i < 200; i++)
+	{
+		MAKE_VALUE(absent, DT_INT, i);
+		rc = findKey(tree, absent, &rid);
+		free(absent);
+		if(rc != RC_IM_KEY_NOT_FOUND)
+			break;
+	}
+	ASSERT_EQUALS_INT(200, i, "absent keys are not found");
+
+	// a second handle on the index shares the entries and the filter
+	TEST_CHECK(openBtree(&other, "testidx"));
+	MAKE_VALUE(absent, DT_INT, 150);
+	TEST_CHECK(insertKey(other, absent, insert[0]));
+	TEST_CHECK(findKey(tree, absent, &rid));
+	ASSERT_EQUALS_RID(insert[0], rid, "a key inserted through another handle is found");
+	TEST_CHECK(closeBtree(other));
+	TEST_CHECK(findKey(tree, absent, &rid));
+	free(absent);
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numInserts);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testOrderStatistics (void)
+{
+	RID insert[] = {
+			{1,1},
+			{2,3},
+			{1,2},
+			{3,5},
+			{4,4},
+			{3,2},
+	};
+	int numInserts = 6;
+	Value **keys;
+	char *stringKeys[] = {
+			"i1",
+			"i11",
+			"i13",
+			"i17",
+			"i23",
+			"i52"
+	};
+
+	testName = "rank, select and count in range";
+	int i, testint;
+	BTreeHandle *tree = NULL;
+	Value *low, *high, *key;
+
+	keys = createValues(stringKeys, numInserts);
+
+	// init
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+
+	// insert keys
+	for(i = 0; i < numInserts; i++)
+		TEST_CHECK(insertKey(tree, keys[i], insert[i]));
+
+	// ranks of present and absent keys
+	for(i = 0; i < numInserts; i++)
+	{
+		TEST_CHECK(getKeyRank(tree, keys[i], &testint));
+		ASSERT_EQUALS_INT(i, testint, "rank of key");
+	}
+	MAKE_VALUE(key, DT_INT, 15);
+	TEST_CHECK(getKeyRank(tree, key, &testint));
+	ASSERT_EQUALS_INT(3, testint, "rank of absent key");
+	free(key);
+
+	// select the median
+	TEST_CHECK(getKeyAtRank(tree, numInserts / 2, &key));
+	ASSERT_EQUALS_INT(17, key->v.intV, "median key");
+	free(key);
+	ASSERT_ERROR(getKeyAtRank(tree, numInserts, &key), "rank out of range");
+
+	// count in [11, 23], [12, 20] and open ranges
+	TEST_CHECK(countKeyRange(tree, keys[1], keys[4], &testint));
+	ASSERT_EQUALS_INT(4, testint, "keys in [11, 23]");
+	MAKE_VALUE(low, DT_INT, 12);
+	MAKE_VALUE(high, DT_INT, 20);
+	TEST_CHECK(countKeyRange(tree, low, high, &testint));
+	ASSERT_EQUALS_INT(2, testint, "keys in [12, 20]");
+	TEST_CHECK(countKeyRange(tree, NULL, high, &testint));
+	ASSERT_EQUALS_INT(4, testint, "keys up to 20");
+	TEST_CHECK(countKeyRange(tree, high, low, &testint));
+	ASSERT_EQUALS_INT(0, testint, "empty range");
+	free(low);
+	free(high);
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numInserts);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testCoveringScan (void)
+{
+	RID insert[] = {
+			{1,1},
+			{2,3},
+			{1,2},
+			{3,5},
+			{4,4},
+			{3,2},
+	};
+	int numInserts = 6;
+	Value **keys, **names;
+	char *stringKeys[] = {
+			"i1",
+			"i11",
+			"i13",
+			"i17",
+			"i23",
+			"i52"
+	};
+	char *stringNames[] = {
+			"saaaa",
+			"sbbbb",
+			"scccc",
+			"sdddd",
+			"seeee",
+			"sffff"
+	};
+	DataType includedTypes[] = { DT_STRING };
+
+	testName = "covering index scan with payload";
+	int i, rc;
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL;
+	RID rid;
+	Value *key, *payload[1];
+	Value **rows[6];
+
+	keys = createValues(stringKeys, numInserts);
+	names = createValues(stringNames, numInserts);
+	for(i = 0; i < numInserts; i++)
+		rows[i] = &names[i];
+
+	// init
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtreeWithPayload("testidx", DT_INT, 2, 1, includedTypes));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+
+	// insert keys in reverse order with their included column
+	for(i = numInserts - 1; i >= 0; i--)
+		TEST_CHECK(insertKeyWithPayload(tree, keys[i], insert[i], &names[i]));
+	ASSERT_ERROR(insertKeyWithPayload(tree, keys[0], insert[0], &keys[0]), "key already exists");
+
+	// scan returns keys and included values in key order
+	openTreeScan(tree, &sc);
+	i = 0;
+	while((rc = nextEntryWithPayload(sc, &key, &rid, payload)) == RC_OK)
+	{
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+		ASSERT_EQUALS_INT(keys[i]->v.intV, key->v.intV, "key returned by the scan");
+		ASSERT_EQUALS_STRING(names[i]->v.stringV, payload[0]->v.stringV, "included column returned by the scan");
+		freeVal(key);
+		freeVal(payload[0]);
+		i++;
+	}
+	ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "no error returned by scan");
+	ASSERT_EQUALS_INT(numInserts, i, "have seen all entries");
+	closeTreeScan(sc);
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// a batch load keeps the included column of every key
+	TEST_CHECK(createBtreeWithPayload("testidx", DT_INT, 2, 1, includedTypes));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(insertKeysWithPayload(tree, keys, insert, rows, numInserts));
+	openTreeScan(tree, &sc);
+	i = 0;
+	while((rc = nextEntryWithPayload(sc, &key, &rid, payload)) == RC_OK)
+	{
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+		ASSERT_TRUE(payload[0] != NULL, "batch loaded entry has its included column");
+		ASSERT_EQUALS_STRING(names[i]->v.stringV, payload[0]->v.stringV, "included column of a batch loaded entry");
+		freeVal(key);
+		freeVal(payload[0]);
+		i++;
+	}
+	ASSERT_EQUALS_INT(numInserts, i, "have seen all batch loaded entries");
+	closeTreeScan(sc);
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numInserts);
+	freeValues(names, numInserts);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testWriteBuffer (void)
+{
+	RID insert[] = {
+			{1,1},
+			{2,3},
+			{1,2},
+			{3,5},
+			{4,4},
+			{3,2},
+	};
+	int numInserts = 6;
+	Value **keys;
+	char *stringKeys[] = {
+			"i1",
+			"i11",
+			"i13",
+			"i17",
+			"i23",
+			"i52"
+	};
+
+	testName = "write buffering mode";
+	int i, testint, rc;
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL;
+	RID rid;
+
+	keys = createValues(stringKeys, numInserts);
+
+	// init
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(setWriteBuffer(tree, 4));
+
+	// insert keys, the buffer is flushed once on the way
+	for(i = 0; i < numInserts; i++)
+		TEST_CHECK(insertKey(tree, keys[i], insert[i]));
+	ASSERT_ERROR(insertKey(tree, keys[5], insert[5]), "buffered key already exists");
+
+	// delete a flushed and a buffered key, then insert one of them again
+	TEST_CHECK(deleteKey(tree, keys[0]));
+	TEST_CHECK(deleteKey(tree, keys[5]));
+	ASSERT_ERROR(deleteKey(tree, keys[5]), "deleted key is not found");
+	rc = findKey(tree, keys[0], &rid);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "entry was deleted, should not find it");
+	TEST_CHECK(insertKey(tree, keys[5], insert[5]));
+
+	// search for keys
+	for(i = 1; i < numInserts; i++)
+	{
+		TEST_CHECK(findKey(tree, keys[i], &rid));
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+	}
+
+	// scans read the pending messages together with the entries, in both directions
+	openTreeScan(tree, &sc);
+	i = 1;
+	while((rc = nextEntry(sc, &rid)) == RC_OK)
+	{
+		RID expRid = insert[i++];
+		ASSERT_EQUALS_RID(expRid, rid, "did we find the correct RID?");
+	}
+	ASSERT_EQUALS_INT(numInserts, i, "have seen all entries");
+	while((rc = prevEntry(sc, &rid)) == RC_OK)
+	{
+		RID expRid = insert[--i];
+		ASSERT_EQUALS_RID(expRid, rid, "did we find the correct RID?");
+	}
+	ASSERT_EQUALS_INT(1, i, "have seen all entries backwards");
+	closeTreeScan(sc);
+
+	// merge the buffer and check the result
+	TEST_CHECK(mergeWriteBuffer(tree));
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numInserts - 1, testint, "number of entries in btree");
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numInserts);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testArtEngine (void)
+{
+	int numInserts = 600;
+	char *stringKeys[] = {
+			"sa",
+			"sab",
+			"sabc",
+			"sb",
+			"sbcd",
+			"sbce"
+	};
+	int numStrings = 6;
+
+	testName = "adaptive radix tree engine";
+	int i, testint, rc, *permute;
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL;
+	Value *key, **strings;
+	RID rid, insert;
+
+	permute = createPermutation(numInserts);
+
+	// init
+	TEST_CHECK(initIndexManager(NULL));
+	ASSERT_ERROR(createBtreeWithEngine("testidx", DT_INT, 2, 7), "unknown engine");
+	TEST_CHECK(createBtreeWithEngine("testidx", DT_INT, 2, IE_ART));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+
+	// insert negative and positive keys in random order, the nodes grow up to Node256
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(key, DT_INT, (permute[i] - numInserts / 2) * 7);
+		insert.page = permute[i];
+		insert.slot = 0;
+		TEST_CHECK(insertKey(tree, key, insert));
+		freeVal(key);
+	}
+	MAKE_VALUE(key, DT_INT, 7);
+	ASSERT_ERROR(insertKey(tree, key, insert), "key already exists");
+	freeVal(key);
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numInserts, testint, "number of entries in the ART");
+
+	// search for keys and for absent keys
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(key, DT_INT, (i - numInserts / 2) * 7);
+		TEST_CHECK(findKey(tree, key, &rid));
+		ASSERT_EQUALS_INT(i, rid.page, "did we find the correct RID?");
+		freeVal(key);
+		MAKE_VALUE(key, DT_INT, (i - numInserts / 2) * 7 + 1);
+		rc = findKey(tree, key, &rid);
+		ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "absent key is not found");
+		freeVal(key);
+	}
+
+	// delete every other key, the nodes shrink again
+	for(i = 0; i < numInserts; i += 2)
+	{
+		MAKE_VALUE(key, DT_INT, (i - numInserts / 2) * 7);
+		TEST_CHECK(deleteKey(tree, key));
+		ASSERT_ERROR(deleteKey(tree, key), "deleted key is not found");
+		freeVal(key);
+	}
+
+	// scans return the keys in order, in both directions
+	openTreeScan(tree, &sc);
+	i = 1;
+	while((rc = nextEntry(sc, &rid)) == RC_OK)
+	{
+		ASSERT_EQUALS_INT(i, rid.page, "did we find the correct RID?");
+		i += 2;
+	}
+	ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "no error returned by scan");
+	ASSERT_EQUALS_INT(numInserts + 1, i, "have seen all entries");
+	while((rc = prevEntry(sc, &rid)) == RC_OK)
+	{
+		i -= 2;
+		ASSERT_EQUALS_INT(i, rid.page, "did we find the correct RID?");
+	}
+	ASSERT_EQUALS_INT(1, i, "have seen all entries backwards");
+	closeTreeScan(sc);
+
+	// the B+ tree only functions report that they need the other engine
+	MAKE_VALUE(key, DT_INT, 0);
+	ASSERT_ERROR(getKeyRank(tree, key, &testint), "order statistics are not supported");
+	ASSERT_ERROR(setBloomFilter(tree, 10), "Bloom filter is not supported");
+	freeVal(key);
+
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// string keys share prefixes, the scan follows strcmp order
+	strings = createValues(stringKeys, numStrings);
+	TEST_CHECK(createBtreeWithEngine("testidx", DT_STRING, 2, IE_ART));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = numStrings - 1; i >= 0; i--)
+	{
+		insert.page = i;
+		TEST_CHECK(insertKey(tree, strings[i], insert));
+	}
+	openTreeScanReverse(tree, &sc);
+	i = numStrings;
+	while((rc = prevEntry(sc, &rid)) == RC_OK)
+	{
+		i--;
+		ASSERT_EQUALS_INT(i, rid.page, "did we find the correct RID?");
+	}
+	ASSERT_EQUALS_INT(0, i, "have seen all entries backwards");
+	closeTreeScan(sc);
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(strings, numStrings);
+	free(permute);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testHashEngine (void)
+{
+	int numInserts = 2000;
+
+	testName = "extendible hash engine";
+	int i, testint, rc;
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL;
+	Value *key;
+	RID rid, insert;
+
+	// init
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtreeWithEngine("testidx", DT_INT, 2, IE_HASH));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+
+	// insert enough keys to split buckets and double the directory
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i * 3);
+		insert.page = i;
+		insert.slot = i % 7;
+		TEST_CHECK(insertKey(tree, key, insert));
+		freeVal(key);
+	}
+	MAKE_VALUE(key, DT_INT, 3);
+	ASSERT_ERROR(insertKey(tree, key, insert), "key already exists");
+	freeVal(key);
+	TEST_CHECK(getNumNodes(tree, &testint));
+	ASSERT_TRUE(testint > 2, "buckets were split");
+
+	// the buckets live in the index pages, so they survive closing the index
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numInserts, testint, "number of entries in the hash index");
+
+	// delete every other key and search for all of them
+	for(i = 0; i < numInserts; i += 2)
+	{
+		MAKE_VALUE(key, DT_INT, i * 3);
+		TEST_CHECK(deleteKey(tree, key));
+		freeVal(key);
+	}
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i * 3);
+		rc = findKey(tree, key, &rid);
+		if(i % 2 == 0)
+			ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "entry was deleted, should not find it");
+		else
+		{
+			ASSERT_EQUALS_INT(RC_OK, rc, "entry is found");
+			ASSERT_EQUALS_INT(i, rid.page, "did we find the correct RID?");
+			ASSERT_EQUALS_INT(i % 7, rid.slot, "did we find the correct RID?");
+		}
+		freeVal(key);
+	}
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numInserts / 2, testint, "number of entries in the hash index");
+
+	// range access needs an ordered engine
+	ASSERT_ERROR(openTreeScan(tree, &sc), "hash index has no scans");
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testLearnedIndex (void)
+{
+	int numInserts = 3000;
+
+	testName = "learned index over integer keys";
+	int i, testint, rc;
+	BTreeHandle *tree = NULL;
+	Value **keys, *key, *high;
+	RID *rids, rid;
+
+	// keys spread unevenly, dense runs with growing gaps
+	keys = (Value **) malloc(sizeof(Value *) * numInserts);
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(keys[i], DT_INT, (i % 100) + (i / 100) * 100 + (i / 100) * (i / 100) * 50 - 10000);
+		rids[i].page = i;
+		rids[i].slot = 0;
+	}
+
+	// init
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(insertKeys(tree, keys, rids, numInserts));
+	TEST_CHECK(setLearnedIndex(tree, 4));
+
+	// search for keys and for the absent keys right after them
+	for(i = 0; i < numInserts; i++)
+	{
+		TEST_CHECK(findKey(tree, keys[i], &rid));
+		ASSERT_EQUALS_INT(i, rid.page, "did we find the correct RID?");
+		MAKE_VALUE(key, DT_INT, keys[i]->v.intV + 100);
+		rc = findKey(tree, key, &rid);
+		if(i % 100 == 99 && i / 100 > 0)
+			ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "key in a gap is not found");
+		freeVal(key);
+	}
+
+	// range positioning uses the model too
+	TEST_CHECK(getKeyRank(tree, keys[1234], &testint));
+	ASSERT_EQUALS_INT(1234, testint, "rank of a key");
+	TEST_CHECK(countKeyRange(tree, keys[1000], keys[2000], &testint));
+	ASSERT_EQUALS_INT(1001, testint, "keys in range");
+	MAKE_VALUE(high, DT_INT, keys[2099]->v.intV + 1);
+	TEST_CHECK(countKeyRange(tree, keys[1000], high, &testint));
+	ASSERT_EQUALS_INT(1100, testint, "keys in range with an absent upper bound");
+	freeVal(high);
+
+	// a write makes the model stale, lookups stay correct until and after it is rebuilt
+	TEST_CHECK(deleteKey(tree, keys[0]));
+	for(i = 1; i < numInserts; i++)
+	{
+		TEST_CHECK(findKey(tree, keys[i], &rid));
+		ASSERT_EQUALS_INT(i, rid.page, "did we find the correct RID?");
+	}
+	rc = findKey(tree, keys[0], &rid);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "entry was deleted, should not find it");
+
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// only integer keys can be modelled
+	TEST_CHECK(createBtree("testidx", DT_STRING, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	ASSERT_ERROR(setLearnedIndex(tree, 4), "learned index needs integer keys");
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numInserts);
+	free(rids);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testFrozenIndex (void)
+{
+	RID insert[] = {
+			{1,1},
+			{2,3},
+			{1,2},
+			{3,5},
+			{4,4},
+			{3,2},
+	};
+	int numInserts = 6;
+	Value **keys, **names;
+	char *stringKeys[] = {
+			"i1",
+			"i11",
+			"i13",
+			"i17",
+			"i23",
+			"i52"
+	};
+	char *stringNames[] = {
+			"sa",
+			"sabcdefghij",
+			"sb",
+			"sbb",
+			"sc",
+			"sd"
+	};
+
+	testName = "frozen read-only index";
+	int i, testint, rc;
+	BTreeHandle *tree = NULL, *shared = NULL;
+	BT_ScanHandle *sc = NULL;
+	Value *key;
+	RID rid;
+
+	keys = createValues(stringKeys, numInserts);
+	names = createValues(stringNames, numInserts);
+
+	// build an index and export it
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numInserts; i++)
+		TEST_CHECK(insertKey(tree, keys[i], insert[i]));
+	TEST_CHECK(exportFrozenBtree(tree, "testfrozen"));
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// two handles map the same file
+	TEST_CHECK(openBtree(&tree, "testfrozen"));
+	TEST_CHECK(openBtree(&shared, "testfrozen"));
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numInserts, testint, "number of entries in the frozen index");
+	TEST_CHECK(getNumNodes(tree, &testint));
+	ASSERT_EQUALS_INT(4, testint, "number of nodes in the packed index");
+	for(i = 0; i < numInserts; i++)
+	{
+		TEST_CHECK(findKey(tree, keys[i], &rid));
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+		TEST_CHECK(findKey(shared, keys[i], &rid));
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+	}
+	MAKE_VALUE(key, DT_INT, 12);
+	rc = findKey(tree, key, &rid);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "absent key is not found");
+	ASSERT_EQUALS_INT(RC_IM_INDEX_READ_ONLY, insertKey(tree, key, insert[0]), "frozen index is read-only");
+	ASSERT_EQUALS_INT(RC_IM_INDEX_READ_ONLY, deleteKey(tree, keys[0]), "frozen index is read-only");
+	freeVal(key);
+
+	// scans in both directions
+	openTreeScan(tree, &sc);
+	i = 0;
+	while((rc = nextEntry(sc, &rid)) == RC_OK)
+	{
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+		i++;
+	}
+	ASSERT_EQUALS_INT(numInserts, i, "have seen all entries");
+	while((rc = prevEntry(sc, &rid)) == RC_OK)
+	{
+		i--;
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+	}
+	ASSERT_EQUALS_INT(0, i, "have seen all entries backwards");
+	closeTreeScan(sc);
+
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(closeBtree(shared));
+	TEST_CHECK(deleteBtree("testfrozen"));
+
+	// string keys are packed into slots as wide as the longest key
+	TEST_CHECK(createBtree("testidx", DT_STRING, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numInserts; i++)
+		TEST_CHECK(insertKey(tree, names[i], insert[i]));
+	TEST_CHECK(exportFrozenBtree(tree, "testfrozen"));
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(openBtree(&tree, "testfrozen"));
+	for(i = 0; i < numInserts; i++)
+	{
+		TEST_CHECK(findKey(tree, names[i], &rid));
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+	}
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testfrozen"));
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numInserts);
+	freeValues(names, numInserts);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testSnapshotScan (void)
+{
+	RID insert[] = {
+			{1,1},
+			{2,3},
+			{1,2},
+			{3,5},
+			{4,4},
+			{3,2},
+	};
+	int numInserts = 6;
+	Value **keys;
+	char *stringKeys[] = {
+			"i1",
+			"i11",
+			"i13",
+			"i17",
+			"i23",
+			"i52"
+	};
+
+	testName = "copy-on-write snapshot scans";
+	int i, testint, rc;
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL, *rsc = NULL;
+	Value *key;
+	RID rid, newRid = {9,9};
+
+	keys = createValues(stringKeys, numInserts);
+
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numInserts; i++)
+		TEST_CHECK(insertKey(tree, keys[i], insert[i]));
+	TEST_CHECK(setCopyOnWrite(tree, TRUE));
+
+	// both scans pin the version from before the writes
+	TEST_CHECK(openTreeScan(tree, &sc));
+	TEST_CHECK(openTreeScanReverse(tree, &rsc));
+	for(i = 0; i < 2; i++)
+	{
+		TEST_CHECK(nextEntry(sc, &rid));
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+	}
+
+	// writes while the scans are open
+	MAKE_VALUE(key, DT_INT, 12);
+	TEST_CHECK(insertKey(tree, key, newRid));
+	TEST_CHECK(deleteKey(tree, keys[3]));
+	TEST_CHECK(deleteKey(tree, keys[0]));
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numInserts - 1, testint, "number of entries after the writes");
+	rc = findKey(tree, keys[3], &rid);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "deleted key is gone for lookups");
+
+	// the open scans still read the old version
+	for(; (rc = nextEntry(sc, &rid)) == RC_OK; i++)
+		ASSERT_EQUALS_RID(insert[i], rid, "scan reads its snapshot");
+	ASSERT_EQUALS_INT(numInserts, i, "snapshot scan has seen all old entries");
+	while((rc = prevEntry(rsc, &rid)) == RC_OK)
+	{
+		i--;
+		ASSERT_EQUALS_RID(insert[i], rid, "reverse scan reads its snapshot");
+	}
+	ASSERT_EQUALS_INT(0, i, "reverse snapshot scan has seen all old entries");
+	TEST_CHECK(closeTreeScan(sc));
+
+	// a new scan reads the published version, buffered writes included
+	TEST_CHECK(setWriteBuffer(tree, 4));
+	TEST_CHECK(insertKey(tree, keys[0], insert[0]));
+	TEST_CHECK(openTreeScan(tree, &sc));
+	TEST_CHECK(nextEntry(sc, &rid));
+	ASSERT_EQUALS_RID(insert[0], rid, "buffered insert is in the new snapshot");
+	TEST_CHECK(nextEntry(sc, &rid));
+	ASSERT_EQUALS_RID(insert[1], rid, "did we find the correct RID?");
+	TEST_CHECK(nextEntry(sc, &rid));
+	ASSERT_EQUALS_RID(newRid, rid, "new key is in the new snapshot");
+	TEST_CHECK(deleteKey(tree, key));
+	TEST_CHECK(mergeWriteBuffer(tree));
+	for(i = 3; nextEntry(sc, &rid) == RC_OK; i++)
+		;
+	ASSERT_EQUALS_INT(numInserts, i, "new snapshot has the new entries only");
+	TEST_CHECK(closeTreeScan(sc));
+	TEST_CHECK(closeTreeScan(rsc));
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numInserts);
+	freeVal(key);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testDefragment (void)
+{
+	RID insert[] = {
+			{1,1},
+			{2,3},
+			{1,2},
+			{3,5},
+			{4,4},
+			{3,2},
+	};
+	int numInserts = 6;
+	Value **keys, **names;
+	char *stringKeys[] = {
+			"i1",
+			"i11",
+			"i13",
+			"i17",
+			"i23",
+			"i52"
+	};
+	char *stringNames[] = {
+			"saaaa",
+			"sbbbb",
+			"scccc",
+			"sdddd",
+			"seeee",
+			"sffff"
+	};
+	DataType includedTypes[] = { DT_INT };
+
+	testName = "defragmenting the entries";
+	int i, testint, rc;
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL;
+	RID rid;
+	Value *key, *payload[1];
+
+	keys = createValues(stringKeys, numInserts);
+	names = createValues(stringNames, numInserts);
+
+	// string keys with an included column, inserted in reverse order
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtreeWithPayload("testidx", DT_STRING, 2, 1, includedTypes));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = numInserts - 1; i >= 0; i--)
+		TEST_CHECK(insertKeyWithPayload(tree, names[i], insert[i], &keys[i]));
+
+	// a snapshot scan opened before the defragmentation keeps reading the old entries
+	TEST_CHECK(setCopyOnWrite(tree, TRUE));
+	TEST_CHECK(openTreeScan(tree, &sc));
+	TEST_CHECK(defragmentBtree(tree));
+	TEST_CHECK(deleteKey(tree, names[2]));
+	TEST_CHECK(defragmentBtree(tree));
+	i = 0;
+	while((rc = nextEntryWithPayload(sc, &key, &rid, payload)) == RC_OK)
+	{
+		ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+		ASSERT_EQUALS_STRING(names[i]->v.stringV, key->v.stringV, "key returned by the scan");
+		ASSERT_EQUALS_INT(keys[i]->v.intV, payload[0]->v.intV, "included column returned by the scan");
+		freeVal(key);
+		freeVal(payload[0]);
+		i++;
+	}
+	ASSERT_EQUALS_INT(numInserts, i, "snapshot scan has seen all old entries");
+	TEST_CHECK(closeTreeScan(sc));
+
+	// lookups, inserts and new scans work on the packed entries
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numInserts - 1, testint, "number of entries after the defragmentation");
+	for(i = 0; i < numInserts; i++)
+	{
+		rc = findKey(tree, names[i], &rid);
+		if(i == 2)
+			ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "deleted key is gone");
+		else
+			ASSERT_EQUALS_RID(insert[i], rid, "did we find the correct RID?");
+	}
+	TEST_CHECK(insertKeyWithPayload(tree, names[2], insert[2], &keys[2]));
+	TEST_CHECK(deleteKey(tree, names[0]));
+	TEST_CHECK(openTreeScan(tree, &sc));
+	for(i = 1; (rc = nextEntryWithPayload(sc, &key, &rid, payload)) == RC_OK; i++)
+	{
+		ASSERT_EQUALS_STRING(names[i]->v.stringV, key->v.stringV, "key returned by the scan");
+		ASSERT_EQUALS_INT(keys[i]->v.intV, payload[0]->v.intV, "included column returned by the scan");
+		freeVal(key);
+		freeVal(payload[0]);
+	}
+	ASSERT_EQUALS_INT(numInserts, i, "have seen all entries");
+	TEST_CHECK(closeTreeScan(sc));
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numInserts);
+	freeValues(names, numInserts);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testNodeSize (void)
+{
+	int numInserts = 3000;
+	int i, testint, rc;
+	BTreeHandle *tree = NULL;
+	RID rid, insert;
+	Value *key;
+	SM_FileHandle fh;
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	char *pages = (char*)malloc(2 * PAGE_SIZE);
+
+	testName = "multi-page nodes and filter pages";
+
+	TEST_CHECK(initIndexManager(NULL));
+	ASSERT_EQUALS_INT(RC_IM_N_TO_LAGE, createBtreeWithNodeSize("testidx", DT_INT, 0), "node needs a page");
+	ASSERT_EQUALS_INT(RC_IM_N_TO_LAGE, createBtreeWithNodeSize("testidx", DT_INT, 17), "node is too large");
+
+	// 16 KB nodes, the Bloom filter spans several pages
+	TEST_CHECK(createBtreeWithNodeSize("testidx", DT_INT, 4));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(setBloomFilter(tree, 20));
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i * 2);
+		insert.page = i;
+		insert.slot = i % 7;
+		TEST_CHECK(insertKey(tree, key, insert));
+		freeVal(key);
+	}
+
+	// 682 keys per node: 5 leaves under a single root
+	TEST_CHECK(getNumNodes(tree, &testint));
+	ASSERT_EQUALS_INT(6, testint, "number of nodes of the shallow tree");
+
+	// reopen, the filter pages are read back with one read
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i * 2);
+		rc = findKey(tree, key, &rid);
+		freeVal(key);
+		if(rc != RC_OK || rid.page != i || rid.slot != i % 7)
+			break;
+	}
+	ASSERT_EQUALS_INT(numInserts, i, "all keys found after reopening");
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i * 2 + 1);
+		rc = findKey(tree, key, &rid);
+		freeVal(key);
+		if(rc != RC_IM_KEY_NOT_FOUND)
+			break;
+	}
+	ASSERT_EQUALS_INT(numInserts, i, "absent keys are not found");
+	TEST_CHECK(closeBtree(tree));
+
+	// the first leaf holds a full node of keys on 4 pages
+	TEST_CHECK(openPageFile("testidx", &fh));
+	TEST_CHECK(readBlock(1, &fh, pages));
+	ASSERT_EQUALS_INT(682, ((int*)pages)[0], "keys of the first leaf node");
+	ASSERT_EQUALS_INT(4, ((int*)pages)[1], "pages of the first leaf node");
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// pages moved with readBlocks/writeBlocks are first written back and dropped from the pool
+	TEST_CHECK(createPageFile("testidx"));
+	TEST_CHECK(initBufferPool(bm, "testidx", 3, RS_FIFO, NULL));
+	TEST_CHECK(pinPage(bm, h, 2));
+	memset(h->data, 'a', PAGE_SIZE);
+	TEST_CHECK(markDirty(bm, h));
+	ASSERT_EQUALS_INT(RC_WRITE_FAILED, discardPages(bm, 1, 2), "a pinned page cannot be dropped");
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(discardPages(bm, 1, 2));
+	TEST_CHECK(openPageFile("testidx", &fh));
+	TEST_CHECK(readBlocks(1, 2, &fh, pages));
+	ASSERT_TRUE(pages[PAGE_SIZE] == 'a', "dirty page is written back before it is dropped");
+	memset(pages, 'b', 2 * PAGE_SIZE);
+	TEST_CHECK(writeBlocks(1, 2, &fh, pages));
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(pinPage(bm, h, 2));
+	ASSERT_TRUE(h->data[0] == 'b', "the pool reads the page written around it");
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(shutdownBufferPool(bm));
+	TEST_CHECK(destroyPageFile("testidx"));
+
+	// cleanup
+	TEST_CHECK(shutdownIndexManager());
+	free(bm);
+	free(h);
+	free(pages);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testScanPrefetch (void)
+{
+	int numInserts = 2000;
+	int i, rc, expected;
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL;
+	RID rid, insert;
+	Value *key;
+	char *files[] = { "testidx", "testfrozen" };
+	int f;
+
+	testName = "scan prefetch window";
+
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numInserts; i++)
+	{
+		MAKE_VALUE(key, DT_INT, i);
+		insert.page = i;
+		insert.slot = 0;
+		TEST_CHECK(insertKey(tree, key, insert));
+		freeVal(key);
+	}
+	TEST_CHECK(exportFrozenBtree(tree, "testfrozen"));
+	TEST_CHECK(closeBtree(tree));
+
+	// the window grows and starts over when the scan turns around
+	for(f = 0; f < 2; f++)
+	{
+		TEST_CHECK(openBtree(&tree, files[f]));
+		TEST_CHECK(openTreeScan(tree, &sc));
+		for(i = 0; i < 1500 && nextEntry(sc, &rid) == RC_OK; i++)
+			if(rid.page != i)
+				break;
+		ASSERT_EQUALS_INT(1500, i, "forward entries in key order");
+		for(expected = 1499; expected >= 1000 && prevEntry(sc, &rid) == RC_OK; expected--)
+			if(rid.page != expected)
+				break;
+		ASSERT_EQUALS_INT(999, expected, "backward entries in key order");
+		for(i = 1000; (rc = nextEntry(sc, &rid)) == RC_OK; i++)
+			if(rid.page != i)
+				break;
+		ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "scan reached the end");
+		ASSERT_EQUALS_INT(numInserts, i, "forward entries up to the end");
+		TEST_CHECK(closeTreeScan(sc));
+		TEST_CHECK(closeBtree(tree));
+	}
+
+	// cleanup
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(deleteBtree("testfrozen"));
+	TEST_CHECK(shutdownIndexManager());
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testIndexOnTable (void)
+{
+	int numRecords = 5;
+	int ids[] = { 5, 1, 9, 3, 7 };
+	char *names[] = { "eeee", "aaaa", "iiii", "cccc", "gggg" };
+	char *attrNames[] = { "a", "b" };
+	DataType dataTypes[] = { DT_INT, DT_STRING };
+	int typeLength[] = { 0, 4 };
+	int keyAttrs[] = { 0 };
+	RID rids[5], rid;
+	RM_TableData *table = (RM_TableData*)malloc(sizeof(RM_TableData));
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL;
+	Schema *schema;
+	Record *record;
+	Value *value;
+	Expr *cond, *left, *right;
+	int i, testint;
+
+	testName = "index built over a table";
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(initIndexManager(NULL));
+	schema = createSchema(2, attrNames, dataTypes, typeLength, 1, keyAttrs);
+	TEST_CHECK(createTable("testtable", schema));
+	TEST_CHECK(openTable(table, "testtable"));
+	TEST_CHECK(createRecord(&record, table->schema));
+	for(i = 0; i < numRecords; i++)
+	{
+		MAKE_VALUE(value, DT_INT, ids[i]);
+		TEST_CHECK(setAttr(record, table->schema, 0, value));
+		freeVal(value);
+		MAKE_STRING_VALUE(value, names[i]);
+		TEST_CHECK(setAttr(record, table->schema, 1, value));
+		freeVal(value);
+		TEST_CHECK(insertRecord(table, record));
+		rids[i] = record->id;
+	}
+
+	ASSERT_EQUALS_INT(RC_IM_NO_SUCH_ATTRIBUTE, createIndexOnTable(table, 2, "testidx"), "attribute out of range");
+
+	// index on the int attribute, every key points to its record
+	TEST_CHECK(createIndexOnTable(table, 0, "testidx"));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(numRecords, testint, "one entry per record");
+	for(i = 0; i < numRecords; i++)
+	{
+		MAKE_VALUE(value, DT_INT, ids[i]);
+		TEST_CHECK(findKey(tree, value, &rid));
+		ASSERT_EQUALS_RID(rids[i], rid, "key points to its record");
+		freeVal(value);
+	}
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// index on the string attribute, scanned in key order
+	TEST_CHECK(createIndexOnTable(table, 1, "testidx"));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(openTreeScan(tree, &sc));
+	for(i = 0; nextEntry(sc, &rid) == RC_OK; i++)
+		;
+	ASSERT_EQUALS_INT(numRecords, i, "scan over the string index");
+	TEST_CHECK(closeTreeScan(sc));
+	MAKE_STRING_VALUE(value, "iiii");
+	TEST_CHECK(findKey(tree, value, &rid));
+	ASSERT_EQUALS_RID(rids[2], rid, "string key points to its record");
+	freeVal(value);
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// partial index on the rows with a < 6
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(right, stringToValue("i6"));
+	MAKE_BINOP_EXPR(cond, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(createPartialIndexOnTable(table, 0, "testidx", cond));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(3, testint, "only the rows of the condition are indexed");
+	for(i = 0; i < numRecords; i++)
+	{
+		MAKE_VALUE(value, DT_INT, ids[i]);
+		if(ids[i] < 6)
+		{
+			TEST_CHECK(findKey(tree, value, &rid));
+			ASSERT_EQUALS_RID(rids[i], rid, "key points to its record");
+		}
+		else
+		{
+			ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, value, &rid), "row outside the condition");
+		}
+		freeVal(value);
+	}
+
+	// the condition is stored with the index and applied to the records inserted later
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 2; i <= 8; i += 6)
+	{
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(setAttr(record, table->schema, 0, value));
+		TEST_CHECK(insertRecord(table, record));
+		TEST_CHECK(insertTableRecord(tree, table, record));
+		if(i < 6)
+		{
+			TEST_CHECK(findKey(tree, value, &rid));
+		}
+		else
+		{
+			ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, value, &rid), "inserted row outside the condition");
+		}
+		freeVal(value);
+	}
+	TEST_CHECK(getNumEntries(tree, &testint));
+	ASSERT_EQUALS_INT(4, testint, "only the inserted row of the condition is added");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	freeExpr(cond);
+
+	// a value found in two records leaves no index behind
+	MAKE_VALUE(value, DT_INT, ids[0]);
+	TEST_CHECK(setAttr(record, table->schema, 0, value));
+	freeVal(value);
+	TEST_CHECK(insertRecord(table, record));
+	ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, createIndexOnTable(table, 0, "testidx"), "duplicate value");
+	ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, openBtree(&tree, "testidx"), "the index was deleted");
+
+	// cleanup
+	TEST_CHECK(freeRecord(record));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("testtable"));
+	TEST_CHECK(shutdownIndexManager());
+	TEST_CHECK(shutdownRecordManager());
+	free(table);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testKeyValue (void)
+{
+	int numKeys = 4;
+	Value **keys;
+	char *stringKeys[] = {
+			"i1",
+			"i2",
+			"i3",
+			"i4"
+	};
+	int bigLength = 10000;
+
+	testName = "key-value store with inline and overflow values";
+	int i, length, rc;
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL;
+	Value *key;
+	char *value, *big, *big2;
+	FILE *overflow;
+
+	keys = createValues(stringKeys, numKeys);
+	big = (char *) malloc(bigLength);
+	big2 = (char *) malloc(bigLength);
+	for(i = 0; i < bigLength; i++)
+	{
+		big[i] = 'a' + i % 26;
+		big2[i] = 'z' - i % 23;
+	}
+
+	// a small value is stored inline, a large one spans overflow pages
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(kvPut(tree, keys[0], "one", 3));
+	TEST_CHECK(kvPut(tree, keys[1], big, bigLength));
+	TEST_CHECK(kvPut(tree, keys[2], "three", 5));
+	TEST_CHECK(kvGet(tree, keys[0], &value, &length));
+	ASSERT_EQUALS_STRING("one", value, "inline value");
+	free(value);
+	TEST_CHECK(kvGet(tree, keys[1], &value, &length));
+	ASSERT_EQUALS_INT(bigLength, length, "length of the overflow value");
+	ASSERT_TRUE(memcmp(big, value, bigLength) == 0, "overflow value");
+	free(value);
+
+	// a snapshot scan keeps the old values while they are replaced and deleted
+	TEST_CHECK(setCopyOnWrite(tree, TRUE));
+	TEST_CHECK(kvScan(tree, &sc));
+	TEST_CHECK(kvPut(tree, keys[1], "two", 3));
+	TEST_CHECK(kvDelete(tree, keys[2]));
+	TEST_CHECK(kvPut(tree, keys[3], big2, bigLength));
+	for(i = 0; (rc = kvNext(sc, &key, &value, &length)) == RC_OK; i++)
+	{
+		ASSERT_EQUALS_INT(keys[i]->v.intV, key->v.intV, "key returned by the scan");
+		if(i == 1)
+			ASSERT_TRUE(length == bigLength && memcmp(big, value, bigLength) == 0, "old overflow value");
+		freeVal(key);
+		free(value);
+	}
+	ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "no error returned by scan");
+	ASSERT_EQUALS_INT(3, i, "snapshot scan has seen the old keys");
+	TEST_CHECK(closeTreeScan(sc));
+
+	// the overflow pages outlive the tree handle
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, kvGet(tree, keys[2], &value, &length), "deleted key is gone");
+	TEST_CHECK(kvGet(tree, keys[1], &value, &length));
+	ASSERT_EQUALS_STRING("two", value, "replaced value");
+	free(value);
+	TEST_CHECK(kvGet(tree, keys[3], &value, &length));
+	ASSERT_TRUE(length == bigLength && memcmp(big2, value, bigLength) == 0, "overflow value after reopening");
+	free(value);
+
+	// the pages of a replaced value are reused
+	TEST_CHECK(kvPut(tree, keys[3], big, bigLength));
+	TEST_CHECK(kvPut(tree, keys[0], big2, bigLength));
+	TEST_CHECK(kvScan(tree, &sc));
+	while((rc = kvNext(sc, &key, &value, &length)) == RC_OK)
+	{
+		if(key->v.intV == keys[3]->v.intV)
+			ASSERT_TRUE(memcmp(big, value, bigLength) == 0, "value in a reused page");
+		if(key->v.intV == keys[0]->v.intV)
+			ASSERT_TRUE(memcmp(big2, value, bigLength) == 0, "value in a reused page");
+		freeVal(key);
+		free(value);
+	}
+	TEST_CHECK(closeTreeScan(sc));
+
+	// the values are written to the leaf pages with their keys and read back on open
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(kvGet(tree, keys[0], &value, &length));
+	ASSERT_TRUE(length == bigLength && memcmp(big2, value, bigLength) == 0, "reused pages after reopening");
+	free(value);
+	TEST_CHECK(kvGet(tree, keys[1], &value, &length));
+	ASSERT_TRUE(length == 3 && memcmp("two", value, 3) == 0, "inline value after reopening");
+	free(value);
+	TEST_CHECK(kvGet(tree, keys[3], &value, &length));
+	ASSERT_TRUE(length == bigLength && memcmp(big, value, bigLength) == 0, "replaced overflow value after reopening");
+	free(value);
+
+	// cleanup, the overflow file goes away with the index
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	overflow = fopen("testidx.ovf", "r");
+	ASSERT_TRUE(overflow == NULL, "overflow file is deleted with the index");
+	TEST_CHECK(shutdownIndexManager());
+	freeValues(keys, numKeys);
+	free(big);
+	free(big2);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testWideKeys (void)
+{
+	int numRecords = 4;
+	long long ids[] = { 5000000000LL, -7000000000LL, 4294967296LL, 3LL };
+	double prices[] = { 0.1, -2.5e300, 19.99, 1e-300 };
+	int order[] = { 1, 3, 0, 2 };
+	char *attrNames[] = { "a", "b" };
+	DataType dataTypes[] = { DT_INT64, DT_DOUBLE };
+	int typeLength[] = { 0, 0 };
+	int keyAttrs[] = { 0 };
+	RID rids[4], rid;
+	RM_TableData *table = (RM_TableData*)malloc(sizeof(RM_TableData));
+	BTreeHandle *tree = NULL;
+	BT_ScanHandle *sc = NULL;
+	Schema *schema;
+	Record *record, *copy;
+	Value *value, *result;
+	Expr *cond, *left, *right;
+	char *serialized;
+	int i;
+
+	testName = "64 bit integer and double keys";
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(initIndexManager(NULL));
+	schema = createSchema(2, attrNames, dataTypes, typeLength, 1, keyAttrs);
+	TEST_CHECK(createTable("testtable", schema));
+	TEST_CHECK(openTable(table, "testtable"));
+	TEST_CHECK(createRecord(&record, table->schema));
+	for(i = 0; i < numRecords; i++)
+	{
+		MAKE_VALUE(value, DT_INT64, ids[i]);
+		TEST_CHECK(setAttr(record, table->schema, 0, value));
+		freeVal(value);
+		MAKE_VALUE(value, DT_DOUBLE, prices[i]);
+		TEST_CHECK(setAttr(record, table->schema, 1, value));
+		freeVal(value);
+		TEST_CHECK(insertRecord(table, record));
+		rids[i] = record->id;
+	}
+
+	// the attributes keep all their bits through getAttr and the serializers
+	TEST_CHECK(getRecord(table, rids[1], record));
+	TEST_CHECK(getAttr(record, table->schema, 0, &value));
+	ASSERT_TRUE(value->dt == DT_INT64 && value->v.int64V == ids[1], "64 bit attribute");
+	freeVal(value);
+	serialized = serializeRecord(record, table->schema);
+	copy = deserializeRecord(serialized, table->schema);
+	TEST_CHECK(getAttr(copy, table->schema, 1, &value));
+	ASSERT_TRUE(value->dt == DT_DOUBLE && value->v.doubleV == prices[1], "double attribute after serializing");
+	freeVal(value);
+	free(serialized);
+	free(copy->data);
+	free(copy);
+
+	// expressions compare them
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(right, stringToValue("l4294967297"));
+	MAKE_BINOP_EXPR(cond, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(evalExpr(record, table->schema, cond, &result));
+	ASSERT_TRUE(result->v.boolV, "64 bit comparison");
+	freeVal(result);
+	freeExpr(cond);
+
+	// index on the 64 bit attribute
+	TEST_CHECK(createIndexOnTable(table, 0, "testidx"));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numRecords; i++)
+	{
+		MAKE_VALUE(value, DT_INT64, ids[i]);
+		TEST_CHECK(findKey(tree, value, &rid));
+		ASSERT_EQUALS_RID(rids[i], rid, "64 bit key points to its record");
+		freeVal(value);
+	}
+	MAKE_VALUE(value, DT_INT64, ids[0] + 1);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, value, &rid), "keys differing above 32 bits are distinct");
+	freeVal(value);
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// double keys sort in numeric order in the B+ tree, the ART engine and a frozen export
+	TEST_CHECK(createBtreeWithEngine("testidx", DT_DOUBLE, 2, IE_ART));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numRecords; i++)
+	{
+		MAKE_VALUE(value, DT_DOUBLE, prices[i]);
+		TEST_CHECK(insertKey(tree, value, rids[i]));
+		freeVal(value);
+	}
+	TEST_CHECK(openTreeScan(tree, &sc));
+	for(i = 0; nextEntry(sc, &rid) == RC_OK; i++)
+		ASSERT_EQUALS_RID(rids[order[i]], rid, "ART scan in key order");
+	ASSERT_EQUALS_INT(numRecords, i, "ART scan has seen all keys");
+	TEST_CHECK(closeTreeScan(sc));
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	TEST_CHECK(createBtree("testidx", DT_DOUBLE, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numRecords; i++)
+	{
+		MAKE_VALUE(value, DT_DOUBLE, prices[i]);
+		TEST_CHECK(insertKey(tree, value, rids[i]));
+		freeVal(value);
+	}
+	TEST_CHECK(exportFrozenBtree(tree, "testfrozen"));
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(openBtree(&tree, "testfrozen"));
+	TEST_CHECK(openTreeScan(tree, &sc));
+	for(i = 0; nextEntry(sc, &rid) == RC_OK; i++)
+		ASSERT_EQUALS_RID(rids[order[i]], rid, "frozen scan in key order");
+	ASSERT_EQUALS_INT(numRecords, i, "frozen scan has seen all keys");
+	TEST_CHECK(closeTreeScan(sc));
+	MAKE_VALUE(value, DT_DOUBLE, prices[3]);
+	TEST_CHECK(findKey(tree, value, &rid));
+	ASSERT_EQUALS_RID(rids[3], rid, "double key in the frozen export");
+	freeVal(value);
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testfrozen"));
+
+	// cleanup
+	TEST_CHECK(freeRecord(record));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("testtable"));
+	TEST_CHECK(shutdownIndexManager());
+	TEST_CHECK(shutdownRecordManager());
+	free(table);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testTreeStats (void)
+{
+	int numKeys = 7;
+	RID rid = {1, 1};
+	BTreeHandle *tree = NULL;
+	BTreeStats stats;
+	Value *value;
+	int i, testint;
+
+	testName = "index structure statistics";
+
+	TEST_CHECK(initIndexManager(NULL));
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	TEST_CHECK(getBtreeStats(tree, &stats));
+	ASSERT_EQUALS_INT(0, stats.height, "empty tree has no levels");
+
+	// 7 keys in leaves of 2: 4 leaves, 2 inner nodes and the root
+	for(i = numKeys; i > 0; i--)
+	{
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(insertKey(tree, value, rid));
+		freeVal(value);
+	}
+	TEST_CHECK(getBtreeStats(tree, &stats));
+	TEST_CHECK(getNumNodes(tree, &testint));
+	ASSERT_EQUALS_INT(3, stats.height, "height");
+	ASSERT_EQUALS_INT(testint, stats.numOfNodes, "node count matches getNumNodes");
+	ASSERT_EQUALS_INT(1, stats.nodesPerLevel[0], "root level");
+	ASSERT_EQUALS_INT(2, stats.nodesPerLevel[1], "inner level");
+	ASSERT_EQUALS_INT(4, stats.nodesPerLevel[2], "leaf level");
+	ASSERT_TRUE(stats.avgFillFactor > 0.71 && stats.avgFillFactor < 0.72, "average fill factor");
+	ASSERT_TRUE(stats.minFillFactor == 0, "minimum fill factor");
+	ASSERT_TRUE(stats.bytesPerEntry > 0, "bytes per entry");
+	ASSERT_TRUE(stats.residentPages > 0 && stats.residentPages <= 1, "resident pages");
+
+	// entries allocated one by one are fragmented until they are packed
+	ASSERT_TRUE(stats.fragmentation > 0, "fragmented entries");
+	TEST_CHECK(defragmentBtree(tree));
+	TEST_CHECK(getBtreeStats(tree, &stats));
+	ASSERT_TRUE(stats.fragmentation == 0, "packed entries");
+
+	// cleanup
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	TEST_CHECK(shutdownIndexManager());
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testInterpolationSearch (void)
+{
+	int numKeys = 1000;
+	int numExtremes = 64;
+	Value **keys = (Value **) malloc(numKeys * sizeof(Value *));
+	RID *rids = (RID *) malloc(numKeys * sizeof(RID));
+	BTreeHandle *tree = NULL;
+	Value *value;
+	RID rid;
+	int i, round, testint;
+
+	testName = "interpolation search over int keys";
+
+	TEST_CHECK(initIndexManager(NULL));
+
+	// uniform keys (multiples of 3) and skewed keys (cubes), the absent keys in between
+	// get their rank from the search as well
+	for(round = 0; round < 2; round++)
+	{
+		for(i = 0; i < numKeys; i++)
+		{
+			MAKE_VALUE(keys[i], DT_INT, (round == 0) ? 3 * i : i * i * i);
+			rids[i].page = i;
+			rids[i].slot = round;
+		}
+		TEST_CHECK(createBtree("testidx", DT_INT, 2));
+		TEST_CHECK(openBtree(&tree, "testidx"));
+		TEST_CHECK(insertKeys(tree, keys, rids, numKeys));
+		TEST_CHECK(setInterpolationSearch(tree, TRUE));
+		for(i = 0; i < numKeys; i++)
+		{
+			TEST_CHECK(findKey(tree, keys[i], &rid));
+			ASSERT_EQUALS_RID(rids[i], rid, "did we find the correct RID?");
+			MAKE_VALUE(value, DT_INT, keys[i]->v.intV + 1);
+			TEST_CHECK(getKeyRank(tree, value, &testint));
+			ASSERT_EQUALS_INT(i + 1, testint, "rank of an absent key");
+			freeVal(value);
+		}
+		TEST_CHECK(closeBtree(tree));
+		TEST_CHECK(deleteBtree("testidx"));
+		for(i = 0; i < numKeys; i++)
+			freeVal(keys[i]);
+	}
+
+	// keys spread evenly over the whole int range, from the smallest to the largest int
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numExtremes; i++)
+	{
+		MAKE_VALUE(value, DT_INT, (int) (-2147483648LL + (long long) i * 4294967295LL / (numExtremes - 1)));
+		TEST_CHECK(insertKey(tree, value, rids[i]));
+		freeVal(value);
+	}
+	TEST_CHECK(setInterpolationSearch(tree, TRUE));
+	for(i = 0; i < numExtremes; i++)
+	{
+		MAKE_VALUE(value, DT_INT, (int) (-2147483648LL + (long long) i * 4294967295LL / (numExtremes - 1)));
+		TEST_CHECK(findKey(tree, value, &rid));
+		ASSERT_EQUALS_RID(rids[i], rid, "key over the whole int range");
+		freeVal(value);
+	}
+	TEST_CHECK(setInterpolationSearch(tree, FALSE));
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// cleanup
+	TEST_CHECK(shutdownIndexManager());
+	free(keys);
+	free(rids);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testEytzingerLayout (void)
+{
+	int numKeys = 1000;
+	char *stringKeys[] = {
+			"s1",
+			"s11",
+			"s13",
+			"s17",
+			"s23",
+			"s52"
+	};
+	int numStrings = 6;
+	Value **strings;
+	BTreeHandle *tree = NULL;
+	Value *value;
+	RID rid;
+	int *permute;
+	int i, testint;
+
+	testName = "Eytzinger layout for read-only searches";
+
+	TEST_CHECK(initIndexManager(NULL));
+
+	// even int keys inserted in random order, the odd keys in between are absent
+	permute = createPermutation(numKeys);
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(value, DT_INT, 2 * permute[i]);
+		rid.page = permute[i];
+		rid.slot = 0;
+		TEST_CHECK(insertKey(tree, value, rid));
+		freeVal(value);
+	}
+	TEST_CHECK(setInterpolationSearch(tree, FALSE));
+	TEST_CHECK(setEytzingerLayout(tree, TRUE));
+	for(i = -1; i <= 2 * numKeys; i++)
+	{
+		MAKE_VALUE(value, DT_INT, i);
+		if(i >= 0 && i < 2 * numKeys && i % 2 == 0)
+		{
+			TEST_CHECK(findKey(tree, value, &rid));
+			ASSERT_EQUALS_INT(i / 2, rid.page, "did we find the correct RID?");
+		}
+		else
+			ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, value, &rid), "absent key");
+		TEST_CHECK(getKeyRank(tree, value, &testint));
+		ASSERT_EQUALS_INT((i < 0) ? 0 : (i + 1) / 2, testint, "rank through the layout");
+		freeVal(value);
+	}
+
+	// a write makes the layout stale, the searches stay correct until it is rebuilt
+	MAKE_VALUE(value, DT_INT, 0);
+	TEST_CHECK(deleteKey(tree, value));
+	freeVal(value);
+	for(i = 0; i < 2 * numKeys; i += 2)
+	{
+		MAKE_VALUE(value, DT_INT, i);
+		TEST_CHECK(getKeyRank(tree, value, &testint));
+		ASSERT_EQUALS_INT((i == 0) ? 0 : i / 2 - 1, testint, "rank after a write");
+		freeVal(value);
+	}
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	free(permute);
+
+	// string keys take the same walk with the generic comparison
+	strings = createValues(stringKeys, numStrings);
+	TEST_CHECK(createBtree("testidx", DT_STRING, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	for(i = 0; i < numStrings; i++)
+	{
+		rid.page = i;
+		rid.slot = 0;
+		TEST_CHECK(insertKey(tree, strings[i], rid));
+	}
+	TEST_CHECK(setEytzingerLayout(tree, TRUE));
+	for(i = 0; i < numStrings; i++)
+	{
+		TEST_CHECK(findKey(tree, strings[i], &rid));
+		ASSERT_EQUALS_INT(i, rid.page, "did we find the correct RID?");
+	}
+	MAKE_STRING_VALUE(value, "2");
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, value, &rid), "absent string key");
+	TEST_CHECK(getKeyRank(tree, value, &testint));
+	ASSERT_EQUALS_INT(4, testint, "rank of an absent string key");
+	freeVal(value);
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+	freeValues(strings, numStrings);
+
+	// cleanup
+	TEST_CHECK(shutdownIndexManager());
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testPageChecksums (void)
+{
+	SM_FileHandle fh;
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	char *page = (char*)malloc(PAGE_SIZE);
+	char *blocks = (char*)malloc(2 * PAGE_SIZE);
+	FILE *file;
+	int i;
+
+	testName = "test page checksums";
+
+	// known answer of CRC32C
+	ASSERT_EQUALS_INT(0xE3069283, (int)crc32c("123456789", 9), "CRC32C of 123456789");
+
+	// write three pages, every block gets its checksum
+	TEST_CHECK(createPageFile("testchecksum"));
+	TEST_CHECK(openPageFile("testchecksum", &fh));
+	TEST_CHECK(ensureCapacity(3, &fh));
+	for(i = 0;i<PAGE_SIZE;i++)
+		page[i] = (char)(i % 251);
+	TEST_CHECK(writeBlock(1, &fh, page));
+	TEST_CHECK(readBlocks(0, 2, &fh, blocks));
+	ASSERT_TRUE(memcmp(blocks + PAGE_SIZE, page, PAGE_SIZE) == 0, "page read back through readBlocks");
+	TEST_CHECK(closePageFile(&fh));
+
+	// flip one byte of page 1 on disk
+	file = fopen("testchecksum", "r+");
+	fseek(file, PAGE_SIZE + (PAGE_SIZE + SM_PAGE_HEADER_SIZE) + SM_PAGE_HEADER_SIZE + 100, SEEK_SET);
+	fputc(page[100] ^ 0x01, file);
+	fclose(file);
+
+	TEST_CHECK(openPageFile("testchecksum", &fh));
+	TEST_CHECK(readBlock(0, &fh, page));
+	TEST_CHECK(readBlock(2, &fh, page));
+	ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_MISMATCH, readBlock(1, &fh, page), "corrupted page is detected by readBlock");
+	ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_MISMATCH, readBlocks(0, 2, &fh, blocks), "corrupted page is detected by readBlocks");
+	TEST_CHECK(closePageFile(&fh));
+
+	// pinPage reports it too and does not keep the page in the pool
+	TEST_CHECK(initBufferPool(bm, "testchecksum", 3, RS_FIFO, NULL));
+	ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_MISMATCH, pinPage(bm, h, 1), "corrupted page is detected by pinPage");
+	ASSERT_EQUALS_INT(RC_PAGE_CHECKSUM_MISMATCH, pinPage(bm, h, 1), "corrupted page is not cached");
+
+	// a page written through the pool gets a new checksum on flush
+	TEST_CHECK(pinPage(bm, h, 2));
+	memset(h->data, 'x', PAGE_SIZE);
+	TEST_CHECK(markDirty(bm, h));
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(forceFlushPool(bm));
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	TEST_CHECK(openPageFile("testchecksum", &fh));
+	TEST_CHECK(readBlock(2, &fh, page));
+	ASSERT_TRUE(page[0] == 'x' && page[PAGE_SIZE - 1] == 'x', "flushed page is read back");
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(destroyPageFile("testchecksum"));
+
+	free(bm);
+	free(h);
+	free(page);
+	free(blocks);
+
+	TEST_DONE();
+}
+
+// ************************************************************ 
+void
+testRangeEstimate (void)
+{
+	int numKeys = 1000;
+	int numBuffered = 50;
+	int ranges[][2] = { {0, 999}, {0, 499}, {100, 199}, {250, 750}, {900, 999}, {10, 12} };
+	int numRanges = sizeof(ranges) / sizeof(ranges[0]);
+	int *permute = createPermutation(numKeys);
+	BTreeHandle *tree = NULL;
+	Value *low, *high;
+	RID rid;
+	int i, exact, estimate;
+
+	testName = "range estimates from the key histogram";
+
+	TEST_CHECK(initIndexManager(NULL));
+	ASSERT_EQUALS_INT(RC_IM_N_TO_LAGE, createBtree("testidx", DT_INT, 0), "a node needs a key");
+	TEST_CHECK(createBtree("testidx", DT_INT, 2));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+
+	// skewed keys (cubes) inserted one by one in random order
+	for(i = 0; i < numKeys; i++)
+	{
+		MAKE_VALUE(low, DT_INT, permute[i] * permute[i] * permute[i]);
+		rid.page = permute[i];
+		rid.slot = 0;
+		TEST_CHECK(insertKey(tree, low, rid));
+		freeVal(low);
+	}
+
+	TEST_CHECK(estimateRangeCount(tree, NULL, NULL, &estimate));
+	ASSERT_EQUALS_INT(numKeys, estimate, "estimate of all keys");
+
+	// the equi-depth buckets follow the skew, every estimate is within 5% of the keys
+	for(i = 0; i < numRanges; i++)
+	{
+		MAKE_VALUE(low, DT_INT, ranges[i][0] * ranges[i][0] * ranges[i][0]);
+		MAKE_VALUE(high, DT_INT, ranges[i][1] * ranges[i][1] * ranges[i][1]);
+		TEST_CHECK(countKeyRange(tree, low, high, &exact));
+		TEST_CHECK(estimateRangeCount(tree, low, high, &estimate));
+		ASSERT_TRUE(estimate >= exact - numKeys / 20 && estimate <= exact + numKeys / 20, "estimate of a key range");
+		freeVal(low);
+		freeVal(high);
+	}
+	MAKE_VALUE(low, DT_INT, 0);
+	low->v.intV = 2000000000;
+	TEST_CHECK(estimateRangeCount(tree, low, NULL, &estimate));
+	ASSERT_EQUALS_INT(0, estimate, "estimate beyond the largest key");
+	freeVal(low);
+
+	// deletes are counted in their buckets
+	for(i = 0; i < numKeys / 2; i++)
+	{
+		MAKE_VALUE(low, DT_INT, i * i * i);
+		TEST_CHECK(deleteKey(tree, low));
+		freeVal(low);
+	}
+	TEST_CHECK(estimateRangeCount(tree, NULL, NULL, &estimate));
+	ASSERT_EQUALS_INT(numKeys / 2, estimate, "estimate after the deletes");
+	MAKE_VALUE(high, DT_INT, (numKeys / 2 - 1) * (numKeys / 2 - 1) * (numKeys / 2 - 1));
+	TEST_CHECK(estimateRangeCount(tree, NULL, high, &estimate));
+	ASSERT_TRUE(estimate <= numKeys / 40, "estimate of the deleted keys");
+	freeVal(high);
+
+	// buffered inserts are counted before they are merged
+	TEST_CHECK(setWriteBuffer(tree, 2 * numBuffered));
+	for(i = numKeys; i < numKeys + numBuffered; i++)
+	{
+		MAKE_VALUE(low, DT_INT, i * i * i);
+		rid.page = i;
+		rid.slot = 0;
+		TEST_CHECK(insertKey(tree, low, rid));
+		freeVal(low);
+	}
+	TEST_CHECK(estimateRangeCount(tree, NULL, NULL, &estimate));
+	ASSERT_EQUALS_INT(numKeys / 2 + numBuffered, estimate, "estimate with pending inserts");
+	TEST_CHECK(setWriteBuffer(tree, 0));
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// the estimate needs the B+ tree engine
+	TEST_CHECK(createBtreeWithEngine("testidx", DT_INT, 2, IE_ART));
+	TEST_CHECK(openBtree(&tree, "testidx"));
+	ASSERT_EQUALS_INT(RC_IM_NOT_SUPPORTED_BY_ENGINE, estimateRangeCount(tree, NULL, NULL, &estimate), "no estimates for the ART engine");
+	TEST_CHECK(closeBtree(tree));
+	TEST_CHECK(deleteBtree("testidx"));
+
+	// cleanup
+	TEST_CHECK(shutdownIndexManager());
+	free(permute);
+
+	TEST_DONE();
+}
+
 // ************************************************************ 
 int *
 createPermutation (int size)